@@ -0,0 +1,665 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <format>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "matrix2d.hpp"
+
+namespace qustrolabe {
+namespace cpp_matrix {
+namespace async {
+
+// Asynchronous execution of row-major matrix expressions.
+//
+//   auto pool = async::ThreadPool(4);
+//   auto expr = async::Add(async::DotProduct2D(a, b), c);
+//   auto future = async::Launch(pool, expr);
+//   const auto& result = future.get();  // or co_await future
+//
+// Calls in this namespace only build a DAG, Launch() schedules it. Every
+// node is split into bands of rows and a band runs as soon as the bands it
+// reads are done, so independent nodes run concurrently and a consumer
+// starts on the first finished bands of its producer. A node's buffer is
+// freed once all of its consumers are done with it.
+
+class ThreadPool {
+ public:
+  explicit ThreadPool(
+      std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+    m_workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+      m_workers.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  // Runs whatever is still queued, then joins
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard lock(m_mutex);
+      m_tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+  }
+
+  auto size() const { return m_workers.size(); }
+
+ private:
+  void WorkerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(m_mutex);
+        m_wake.wait(lock, [this] { return m_stopping or !m_tasks.empty(); });
+        if (m_tasks.empty()) return;
+
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::deque<std::function<void()>> m_tasks;
+  bool m_stopping = false;
+  std::vector<std::thread> m_workers;
+};
+
+struct AsyncOptions {
+  // Rows per band, the unit of scheduling
+  int band_rows = 64;
+};
+
+namespace detail {
+
+enum class AsyncKind {
+  Source,
+  Add,
+  Sub,
+  AddScalar,
+  MultScalar,
+  DotProduct2D,
+  Transpose
+};
+
+// Immutable DAG node, shared between expressions and launches
+template <typename T>
+struct AsyncNode {
+  AsyncKind kind;
+  Shape2D<int> shape;
+  std::vector<std::shared_ptr<const AsyncNode>> inputs{};
+  T scalar{};
+  // Sources either borrow a matrix or own a moved-in one
+  const Matrix2D<T>* source = nullptr;
+  std::optional<Matrix2D<T>> owned{};
+};
+
+// Result slot shared by Future copies and the running execution
+template <typename T>
+class AsyncState {
+ public:
+  void SetValue(Matrix2D<T>&& value) {
+    std::unique_lock lock(m_mutex);
+    m_value.emplace(std::move(value));
+    Complete(lock);
+  }
+
+  void SetException(std::exception_ptr exception) {
+    std::unique_lock lock(m_mutex);
+    m_exception = exception;
+    Complete(lock);
+  }
+
+  bool Ready() const {
+    std::lock_guard lock(m_mutex);
+    return m_ready;
+  }
+
+  void Wait() const {
+    std::unique_lock lock(m_mutex);
+    m_ready_cv.wait(lock, [this] { return m_ready; });
+  }
+
+  const Matrix2D<T>& Get() const {
+    Wait();
+    if (m_exception) std::rethrow_exception(m_exception);
+    return *m_value;
+  }
+
+  // Returns false when already complete and the caller shouldn't suspend
+  bool Suspend(std::coroutine_handle<> handle) {
+    std::lock_guard lock(m_mutex);
+    if (m_ready) return false;
+
+    m_waiters.push_back(handle);
+    return true;
+  }
+
+ private:
+  // Waiters resume on the completing thread, outside the lock
+  void Complete(std::unique_lock<std::mutex>& lock) {
+    m_ready = true;
+    auto waiters = std::move(m_waiters);
+    lock.unlock();
+
+    m_ready_cv.notify_all();
+    for (auto handle : waiters) {
+      handle.resume();
+    }
+  }
+
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_ready_cv;
+  bool m_ready = false;
+  std::optional<Matrix2D<T>> m_value{};
+  std::exception_ptr m_exception{};
+  std::vector<std::coroutine_handle<>> m_waiters{};
+};
+
+template <typename T>
+class AsyncExecution;
+
+}  // namespace detail
+
+// Handle to a node of the expression DAG. Copies share the node, so an
+// expression used twice is computed once per launch.
+template <typename T>
+class Expr {
+ public:
+  using ValueType = T;
+
+ public:
+  // Borrows matrix, it must outlive every launch that reads it
+  Expr(const Matrix2D<T>& matrix) : Expr(Source(matrix.shape())) {
+    m_node->source = &matrix;
+  }
+
+  Expr(Matrix2D<T>&& matrix) : Expr(Source(matrix.shape())) {
+    m_node->owned.emplace(std::move(matrix));
+    m_node->source = &*m_node->owned;
+  }
+
+  explicit Expr(std::shared_ptr<detail::AsyncNode<T>> node)
+      : m_node{std::move(node)} {}
+
+  auto rows() const { return m_node->shape.rows; }
+  auto cols() const { return m_node->shape.cols; }
+  auto shape() const { return m_node->shape; }
+
+  std::shared_ptr<const detail::AsyncNode<T>> node() const { return m_node; }
+
+ private:
+  static std::shared_ptr<detail::AsyncNode<T>> Source(Shape2D<int> shape) {
+    return std::make_shared<detail::AsyncNode<T>>(
+        detail::AsyncNode<T>{detail::AsyncKind::Source, shape});
+  }
+
+  std::shared_ptr<detail::AsyncNode<T>> m_node;
+};
+
+namespace detail {
+
+template <typename E>
+struct AsyncOperandTraits {};
+
+template <typename T>
+struct AsyncOperandTraits<Matrix2D<T>> {
+  using ValueType = T;
+};
+
+template <typename T>
+struct AsyncOperandTraits<Expr<T>> {
+  using ValueType = T;
+};
+
+}  // namespace detail
+
+// Matrix2D<T> (row-major) or Expr<T>
+template <typename E>
+concept AsyncOperand = requires {
+  typename detail::AsyncOperandTraits<std::remove_cvref_t<E>>::ValueType;
+};
+
+template <AsyncOperand E>
+using AsyncValueType =
+    typename detail::AsyncOperandTraits<std::remove_cvref_t<E>>::ValueType;
+
+namespace detail {
+
+template <typename T, typename... Operands>
+Expr<T> MakeNode(AsyncKind kind, Shape2D<int> shape, T scalar,
+                 Operands&&... operands) {
+  auto node = std::make_shared<AsyncNode<T>>(AsyncNode<T>{kind, shape});
+  node->inputs = {Expr<T>(std::forward<Operands>(operands)).node()...};
+  node->scalar = scalar;
+  return Expr<T>(std::move(node));
+}
+
+}  // namespace detail
+
+// DAG builders, same shape rules and exceptions as the blocking versions
+
+template <AsyncOperand Lhs, AsyncOperand Rhs,
+          typename T = AsyncValueType<Lhs>>
+  requires std::is_same_v<T, AsyncValueType<Rhs>>
+Expr<T> Add(Lhs&& lhs, Rhs&& rhs) {
+  if (lhs.shape() != rhs.shape())
+    throw ShapeMismatchException("Add(): Shape mismatch");
+
+  return detail::MakeNode<T>(detail::AsyncKind::Add, lhs.shape(), T{},
+                             std::forward<Lhs>(lhs), std::forward<Rhs>(rhs));
+}
+
+template <AsyncOperand Lhs, AsyncOperand Rhs,
+          typename T = AsyncValueType<Lhs>>
+  requires std::is_same_v<T, AsyncValueType<Rhs>>
+Expr<T> Sub(Lhs&& lhs, Rhs&& rhs) {
+  if (lhs.shape() != rhs.shape())
+    throw ShapeMismatchException("Sub(): Shape mismatch");
+
+  return detail::MakeNode<T>(detail::AsyncKind::Sub, lhs.shape(), T{},
+                             std::forward<Lhs>(lhs), std::forward<Rhs>(rhs));
+}
+
+template <AsyncOperand Operand>
+Expr<AsyncValueType<Operand>> AddScalar(Operand&& operand,
+                                  AsyncValueType<Operand> scalar) {
+  using T = AsyncValueType<Operand>;
+  auto shape = operand.shape();
+  return detail::MakeNode<T>(detail::AsyncKind::AddScalar, shape, scalar,
+                             std::forward<Operand>(operand));
+}
+
+template <AsyncOperand Operand>
+Expr<AsyncValueType<Operand>> MultScalar(Operand&& operand,
+                                  AsyncValueType<Operand> scalar) {
+  using T = AsyncValueType<Operand>;
+  auto shape = operand.shape();
+  return detail::MakeNode<T>(detail::AsyncKind::MultScalar, shape, scalar,
+                             std::forward<Operand>(operand));
+}
+
+template <AsyncOperand Operand, typename T = AsyncValueType<Operand>>
+Expr<T> Transpose(Operand&& operand) {
+  auto shape = Shape2D{operand.cols(), operand.rows()};
+  return detail::MakeNode<T>(detail::AsyncKind::Transpose, shape, T{},
+                             std::forward<Operand>(operand));
+}
+
+template <AsyncOperand Lhs, AsyncOperand Rhs,
+          typename T = AsyncValueType<Lhs>>
+  requires std::is_same_v<T, AsyncValueType<Rhs>>
+Expr<T> DotProduct2D(Lhs&& lhs, Rhs&& rhs) {
+  auto lhs_shape = lhs.shape();
+  auto rhs_shape = rhs.shape();
+
+  if (lhs_shape.cols != rhs_shape.rows) {
+    std::string message =
+        std::format("ShapeMismatchException: {}x{} dot {}x{}", lhs_shape.rows,
+                    lhs_shape.cols, rhs_shape.rows, rhs_shape.cols);
+    throw ShapeMismatchException(message);
+  }
+
+  return detail::MakeNode<T>(detail::AsyncKind::DotProduct2D,
+                             Shape2D{lhs_shape.rows, rhs_shape.cols}, T{},
+                             std::forward<Lhs>(lhs), std::forward<Rhs>(rhs));
+}
+
+// Result of a launch. Copyable, every copy sees the same matrix.
+// Don't block on get() from inside a pool task, co_await instead.
+template <typename T>
+class Future {
+ public:
+  explicit Future(std::shared_ptr<detail::AsyncState<T>> state)
+      : m_state{std::move(state)} {}
+
+  bool ready() const { return m_state->Ready(); }
+  void wait() const { m_state->Wait(); }
+
+  // Rethrows the first exception a band threw
+  const Matrix2D<T>& get() const { return m_state->Get(); }
+
+  // The coroutine resumes on the pool thread that finished the last band
+  auto operator co_await() const {
+    struct Awaiter {
+      std::shared_ptr<detail::AsyncState<T>> state;
+
+      bool await_ready() const { return state->Ready(); }
+      bool await_suspend(std::coroutine_handle<> handle) {
+        return state->Suspend(handle);
+      }
+      const Matrix2D<T>& await_resume() const { return state->Get(); }
+    };
+
+    return Awaiter{m_state};
+  }
+
+ private:
+  std::shared_ptr<detail::AsyncState<T>> m_state;
+};
+
+namespace detail {
+
+// Per-launch run state over a topologically sorted copy of the DAG
+template <typename T>
+class AsyncExecution
+    : public std::enable_shared_from_this<AsyncExecution<T>> {
+ public:
+  AsyncExecution(ThreadPool& pool, std::shared_ptr<const AsyncNode<T>> root,
+                 AsyncOptions options,
+                 std::shared_ptr<AsyncState<T>> state)
+      : m_pool{pool},
+        m_root_node{std::move(root)},
+        m_band_rows{std::max(options.band_rows, 1)},
+        m_state{std::move(state)} {
+    std::unordered_map<const AsyncNode<T>*, std::size_t> index{};
+    std::vector<const AsyncNode<T>*> order{};
+    Sort(m_root_node.get(), index, order);
+
+    m_nodes = std::vector<RunNode>(order.size());
+    m_root = order.size() - 1;
+
+    for (std::size_t n = 0; n < order.size(); n++) {
+      auto& run = m_nodes[n];
+      run.node = order[n];
+      run.bands = std::max(1, (run.node->shape.rows + m_band_rows - 1) /
+                                  m_band_rows);
+      run.waiting = std::make_unique<std::atomic<int>[]>(run.bands);
+
+      for (std::size_t slot = 0; slot < run.node->inputs.size(); slot++) {
+        run.slots.push_back({index.at(run.node->inputs[slot].get()),
+                             ReadsWholeInput(run.node->kind, slot)});
+      }
+    }
+
+    // Band dependency counts, reader counts and consumer lists
+    for (std::size_t n = 0; n < m_nodes.size(); n++) {
+      auto& run = m_nodes[n];
+      if (!IsSource(run)) m_bands_left += run.bands;
+
+      for (const auto& slot : run.slots) {
+        auto& input = m_nodes[slot.input];
+        if (IsSource(input)) continue;
+
+        for (int band = 0; band < run.bands; band++) {
+          run.waiting[band] += slot.whole ? input.bands : 1;
+        }
+        input.reads_left += run.bands;
+
+        auto& consumers = input.consumers;
+        if (std::find(consumers.begin(), consumers.end(), n) ==
+            consumers.end()) {
+          consumers.push_back(n);
+        }
+      }
+    }
+  }
+
+  void Start() {
+    const auto& root = m_nodes[m_root];
+    if (IsSource(root)) {
+      m_state->SetValue(Matrix2D<T>(*root.node->source));
+      return;
+    }
+
+    // Collected before submitting anything, running bands already count
+    // the rest down
+    std::vector<std::pair<std::size_t, int>> ready{};
+    for (std::size_t n = 0; n < m_nodes.size(); n++) {
+      if (IsSource(m_nodes[n])) continue;
+
+      for (int band = 0; band < m_nodes[n].bands; band++) {
+        if (m_nodes[n].waiting[band] == 0) ready.emplace_back(n, band);
+      }
+    }
+
+    for (auto [n, band] : ready) {
+      Submit(n, band);
+    }
+  }
+
+ private:
+  struct Slot {
+    std::size_t input;
+    // Every band of the input is needed, not just the matching one
+    bool whole;
+  };
+
+  struct RunNode {
+    const AsyncNode<T>* node = nullptr;
+    std::vector<Slot> slots{};
+    std::vector<std::size_t> consumers{};
+    int bands = 0;
+    std::unique_ptr<std::atomic<int>[]> waiting{};
+    // Consumer bands that still have to read this node
+    std::atomic<int> reads_left{0};
+    std::once_flag allocated{};
+    Matrix2D<T> value{Shape2D{0, 0}};
+  };
+
+  static bool ReadsWholeInput(AsyncKind kind, std::size_t slot) {
+    return kind == AsyncKind::Transpose or
+           (kind == AsyncKind::DotProduct2D and slot == 1);
+  }
+
+  static bool IsSource(const RunNode& run) {
+    return run.node->kind == AsyncKind::Source;
+  }
+
+  static void Sort(const AsyncNode<T>* node,
+                   std::unordered_map<const AsyncNode<T>*, std::size_t>& index,
+                   std::vector<const AsyncNode<T>*>& order) {
+    if (index.contains(node)) return;
+
+    for (const auto& input : node->inputs) {
+      Sort(input.get(), index, order);
+    }
+    index.emplace(node, order.size());
+    order.push_back(node);
+  }
+
+  const Matrix2D<T>& Value(std::size_t n) const {
+    const auto& run = m_nodes[n];
+    return IsSource(run) ? *run.node->source : run.value;
+  }
+
+  void Submit(std::size_t n, int band) {
+    m_pool.submit(
+        [self = this->shared_from_this(), n, band] { self->RunBand(n, band); });
+  }
+
+  void RunBand(std::size_t n, int band) {
+    if (!m_failed) {
+      try {
+        auto& run = m_nodes[n];
+        std::call_once(run.allocated,
+                       [&] { run.value = Matrix2D<T>(run.node->shape); });
+        ComputeBand(n, band);
+      } catch (...) {
+        if (!m_failed.exchange(true)) m_exception = std::current_exception();
+      }
+    }
+
+    FinishBand(n, band);
+  }
+
+  void ComputeBand(std::size_t n, int band) {
+    auto& run = m_nodes[n];
+    const auto* node = run.node;
+    auto shape = node->shape;
+    int row_begin = band * m_band_rows;
+    int row_end = std::min(row_begin + m_band_rows, shape.rows);
+    std::uint64_t band_elements =
+        std::uint64_t(std::max(row_end - row_begin, 0)) * shape.cols;
+
+    T* out = run.value.data().data();
+    const T* lhs = Value(run.slots[0].input).data().data();
+    std::size_t begin = std::size_t(row_begin) * shape.cols;
+    std::size_t end = begin + band_elements;
+    T scalar = node->scalar;
+
+    // Profiled per band, so calls count bands rather than nodes. Bytes are
+    // the band's share of the node's buffer.
+    switch (node->kind) {
+      case AsyncKind::Add: {
+        CPP_MATRIX_PROFILE_OP(Add, band_elements, band_elements,
+                              band_elements * sizeof(T));
+        const T* rhs = Value(run.slots[1].input).data().data();
+        for (std::size_t i = begin; i < end; i++) out[i] = lhs[i] + rhs[i];
+        break;
+      }
+      case AsyncKind::Sub: {
+        CPP_MATRIX_PROFILE_OP(Sub, band_elements, band_elements,
+                              band_elements * sizeof(T));
+        const T* rhs = Value(run.slots[1].input).data().data();
+        for (std::size_t i = begin; i < end; i++) out[i] = lhs[i] - rhs[i];
+        break;
+      }
+      case AsyncKind::AddScalar: {
+        CPP_MATRIX_PROFILE_OP(AddScalar, band_elements, band_elements,
+                              band_elements * sizeof(T));
+        for (std::size_t i = begin; i < end; i++) out[i] = lhs[i] + scalar;
+        break;
+      }
+      case AsyncKind::MultScalar: {
+        CPP_MATRIX_PROFILE_OP(MultScalar, band_elements, band_elements,
+                              band_elements * sizeof(T));
+        for (std::size_t i = begin; i < end; i++) out[i] = lhs[i] * scalar;
+        break;
+      }
+      case AsyncKind::Transpose: {
+        CPP_MATRIX_PROFILE_OP(Transpose, band_elements, 0,
+                              band_elements * sizeof(T));
+        int in_cols = shape.rows;
+        for (int row = row_begin; row < row_end; row++) {
+          for (int col = 0; col < shape.cols; col++) {
+            out[row * shape.cols + col] = lhs[col * in_cols + row];
+          }
+        }
+        break;
+      }
+      case AsyncKind::DotProduct2D: {
+        const auto& rhs_matrix = Value(run.slots[1].input);
+        int inner = rhs_matrix.rows();
+        CPP_MATRIX_PROFILE_OP(DotProduct2D, band_elements,
+                              2 * band_elements * inner,
+                              band_elements * sizeof(T));
+        const T* rhs = rhs_matrix.data().data();
+
+        for (int i = row_begin; i < row_end; i++) {
+          T* out_row = out + std::size_t(i) * shape.cols;
+          for (int k = 0; k < inner; k++) {
+            T a_ik = lhs[std::size_t(i) * inner + k];
+            const T* rhs_row = rhs + std::size_t(k) * shape.cols;
+            for (int j = 0; j < shape.cols; j++) {
+              out_row[j] += a_ik * rhs_row[j];
+            }
+          }
+        }
+        break;
+      }
+      case AsyncKind::Source:
+        break;
+    }
+  }
+
+  void FinishBand(std::size_t n, int band) {
+    auto& run = m_nodes[n];
+
+    // This band no longer reads its inputs
+    for (const auto& slot : run.slots) {
+      auto& input = m_nodes[slot.input];
+      if (IsSource(input)) continue;
+
+      if (--input.reads_left == 0) input.value = Matrix2D<T>(Shape2D{0, 0});
+    }
+
+    // Wake consumer bands waiting on this one
+    for (auto consumer : run.consumers) {
+      auto& next = m_nodes[consumer];
+
+      for (const auto& slot : next.slots) {
+        if (slot.input != n) continue;
+
+        if (slot.whole) {
+          for (int b = 0; b < next.bands; b++) {
+            if (--next.waiting[b] == 0) Submit(consumer, b);
+          }
+        } else if (--next.waiting[band] == 0) {
+          Submit(consumer, band);
+        }
+      }
+    }
+
+    // Completed only once every band is done, so a failed launch no longer
+    // touches borrowed sources when get() throws
+    if (--m_bands_left == 0) {
+      if (m_failed) {
+        m_state->SetException(m_exception);
+      } else {
+        m_state->SetValue(std::move(m_nodes[m_root].value));
+      }
+    }
+  }
+
+  ThreadPool& m_pool;
+  std::shared_ptr<const AsyncNode<T>> m_root_node;
+  int m_band_rows;
+  std::shared_ptr<AsyncState<T>> m_state;
+  std::vector<RunNode> m_nodes{};
+  std::size_t m_root = 0;
+  // Bands of every node that have yet to finish
+  std::atomic<int> m_bands_left{0};
+  std::atomic<bool> m_failed{false};
+  // Written once by the band that sets m_failed
+  std::exception_ptr m_exception{};
+};
+
+}  // namespace detail
+
+// Schedules expr on pool and returns right away
+template <typename T>
+Future<T> Launch(ThreadPool& pool, const Expr<T>& expr,
+                 AsyncOptions options = {}) {
+  auto state = std::make_shared<detail::AsyncState<T>>();
+  auto execution = std::make_shared<detail::AsyncExecution<T>>(
+      pool, expr.node(), options, state);
+  execution->Start();
+
+  return Future<T>(std::move(state));
+}
+
+}  // namespace async
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
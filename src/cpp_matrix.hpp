@@ -1,5 +1,11 @@
 #pragma once
 
+#include "async.hpp"
 #include "matrix2d.hpp"
 #include "matrix2darray.hpp"
+#include "matrix2dview.hpp"
+#include "matrixchain.hpp"
+#include "quantized.hpp"
+#include "strassen.hpp"
+#include "structured.hpp"
 #include "vec.hpp"
\ No newline at end of file
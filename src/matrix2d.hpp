@@ -1,8 +1,19 @@
 #pragma once
+#include <algorithm>
 #include <random>
 #include <stdexcept>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include <version>
+
+#ifdef __cpp_lib_mdspan
+#include <mdspan>
+#endif
+
+#include "profiling.hpp"
 
 namespace qustrolabe {
 namespace cpp_matrix {
@@ -25,10 +36,37 @@ struct Shape2D {
   auto operator<=>(const Shape2D&) const = default;
 };
 
-template <typename T>
+// Storage order policies. Offset() maps (row, col) to a position in the
+// flat buffer, MdspanLayout is the equivalent std::mdspan layout.
+struct RowMajor {
+  template <typename SizeType>
+  static constexpr SizeType Offset(Shape2D<SizeType> shape, SizeType row,
+                                   SizeType col) {
+    return row * shape.cols + col;
+  }
+
+#ifdef __cpp_lib_mdspan
+  using MdspanLayout = std::layout_right;
+#endif
+};
+
+struct ColMajor {
+  template <typename SizeType>
+  static constexpr SizeType Offset(Shape2D<SizeType> shape, SizeType row,
+                                   SizeType col) {
+    return row + col * shape.rows;
+  }
+
+#ifdef __cpp_lib_mdspan
+  using MdspanLayout = std::layout_left;
+#endif
+};
+
+template <typename T, typename Layout = RowMajor>
 class Matrix2D {
  public:
   using SizeType = int;
+  using LayoutType = Layout;
 
  public:
   Matrix2D(Shape2D<SizeType> shape, T init_value = {})
@@ -147,14 +185,14 @@ class Matrix2D {
     if (row < 0 or row >= m_shape.rows) throw std::out_of_range("Out of row");
     if (col < 0 or col >= m_shape.cols) throw std::out_of_range("Out of col");
 
-    return m_data.at(row * m_shape.cols + col);
+    return m_data.at(Layout::Offset(m_shape, row, col));
   }
 
   T& get(SizeType row, SizeType col) {
     if (row < 0 or row >= m_shape.rows) throw std::out_of_range("Out of row");
     if (col < 0 or col >= m_shape.cols) throw std::out_of_range("Out of col");
 
-    return m_data.at(row * m_shape.cols + col);
+    return m_data.at(Layout::Offset(m_shape, row, col));
   }
 
   bool operator==(const Matrix2D& other) const = default;
@@ -164,33 +202,128 @@ class Matrix2D {
   auto shape() const { return m_shape; }
 
   auto& data() { return m_data; }
+  const auto& data() const { return m_data; }
   //[1,2] operator
 
+  // Changes the shape and refills every element, reusing the allocation
+  // when it is already large enough
+  void resize(Shape2D<SizeType> shape, T init_value = {}) {
+    m_shape = shape;
+    m_data.assign(shape.rows * shape.cols, init_value);
+  }
+
+#ifdef __cpp_lib_mdspan
+  using Extents = std::dextents<SizeType, 2>;
+
+  // Non-owning std::mdspan over the same buffer
+  auto mdspan() {
+    return std::mdspan<T, Extents, typename Layout::MdspanLayout>(
+        m_data.data(), m_shape.rows, m_shape.cols);
+  }
+  auto mdspan() const {
+    return std::mdspan<const T, Extents, typename Layout::MdspanLayout>(
+        m_data.data(), m_shape.rows, m_shape.cols);
+  }
+#endif
+
  private:
   Shape2D<SizeType> m_shape;
   std::vector<T> m_data;
 };
 
-template <typename T>
-Matrix2D<T> Add(const Matrix2D<T>& lhs, const Matrix2D<T>& rhs) {
+namespace detail {
+
+// Visit every (row, col) in the storage order of Layout
+template <typename Layout, typename SizeType, typename Function>
+void ForEachInStorageOrder(Shape2D<SizeType> shape, Function&& function) {
+  if constexpr (std::is_same_v<Layout, ColMajor>) {
+    for (SizeType col = 0; col < shape.cols; col++) {
+      for (SizeType row = 0; row < shape.rows; row++) {
+        function(row, col);
+      }
+    }
+  } else {
+    for (SizeType row = 0; row < shape.rows; row++) {
+      for (SizeType col = 0; col < shape.cols; col++) {
+        function(row, col);
+      }
+    }
+  }
+}
+
+// Copy src to dst, or to its transpose, in square tiles so that the side
+// walked against its storage order stays in cache
+template <bool kTranspose, typename SrcLayout, typename DstLayout,
+          typename T, typename SizeType>
+void TiledCopy(const T* src, Shape2D<SizeType> src_shape, T* dst) {
+  constexpr SizeType kTile = 32;
+  auto dst_shape = kTranspose ? Shape2D{src_shape.cols, src_shape.rows}
+                              : src_shape;
+
+  for (SizeType row_block = 0; row_block < src_shape.rows;
+       row_block += kTile) {
+    SizeType row_end = std::min(row_block + kTile, src_shape.rows);
+
+    for (SizeType col_block = 0; col_block < src_shape.cols;
+         col_block += kTile) {
+      SizeType col_end = std::min(col_block + kTile, src_shape.cols);
+
+      for (SizeType row = row_block; row < row_end; row++) {
+        for (SizeType col = col_block; col < col_end; col++) {
+          const T& value = src[SrcLayout::Offset(src_shape, row, col)];
+
+          if constexpr (kTranspose) {
+            dst[DstLayout::Offset(dst_shape, col, row)] = value;
+          } else {
+            dst[DstLayout::Offset(dst_shape, row, col)] = value;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+template <typename T, typename LhsLayout, typename RhsLayout>
+Matrix2D<T, LhsLayout> Add(const Matrix2D<T, LhsLayout>& lhs,
+                           const Matrix2D<T, RhsLayout>& rhs) {
   using SizeType = Matrix2D<T>::SizeType;
 
   if (lhs.shape() != rhs.shape())
     throw ShapeMismatchException("Add(): Shape mismatch");
 
-  auto result = Matrix2D<T>(lhs.shape());
+  auto shape = lhs.shape();
+  CPP_MATRIX_PROFILE_OP(Add, lhs.data().size(), lhs.data().size(),
+                        lhs.data().size() * sizeof(T));
 
-  for (SizeType i = 0; i < lhs.rows(); i++) {
-    for (SizeType j = 0; j < lhs.cols(); j++) {
-      result.get(i, j) = lhs.get(i, j) + rhs.get(i, j);
+  auto result = Matrix2D<T, LhsLayout>(shape);
+  auto& out = result.data();
+  const auto& a = lhs.data();
+  const auto& b = rhs.data();
+
+  if constexpr (std::is_same_v<LhsLayout, RhsLayout>) {
+    for (std::size_t i = 0; i < out.size(); i++) {
+      out[i] = a[i] + b[i];
     }
+  } else {
+    // result follows lhs, so only rhs is read against its storage order
+    detail::ForEachInStorageOrder<LhsLayout>(
+        shape, [&](SizeType row, SizeType col) {
+          auto i = LhsLayout::Offset(shape, row, col);
+          out[i] = a[i] + b[RhsLayout::Offset(shape, row, col)];
+        });
   }
 
   return result;
 }
 
-template <typename T>
-Matrix2D<T> AddScalar(Matrix2D<T> matrix_copy, T scalar) {
+template <typename T, typename Layout>
+Matrix2D<T, Layout> AddScalar(Matrix2D<T, Layout> matrix_copy, T scalar) {
+  CPP_MATRIX_PROFILE_OP(AddScalar, matrix_copy.data().size(),
+                        matrix_copy.data().size(),
+                        matrix_copy.data().size() * sizeof(T));
+
   for (auto& e : matrix_copy.data()) {
     e += scalar;
   }
@@ -198,44 +331,141 @@ Matrix2D<T> AddScalar(Matrix2D<T> matrix_copy, T scalar) {
   return matrix_copy;
 }
 
-template <typename T>
-Matrix2D<T> MultScalar(Matrix2D<T> matrix_copy, T scalar) {
+template <typename T, typename Layout>
+Matrix2D<T, Layout> MultScalar(Matrix2D<T, Layout> matrix_copy, T scalar) {
+  CPP_MATRIX_PROFILE_OP(MultScalar, matrix_copy.data().size(),
+                        matrix_copy.data().size(),
+                        matrix_copy.data().size() * sizeof(T));
+
   for (auto& e : matrix_copy.data()) {
     e *= scalar;
   }
 
   return matrix_copy;
 }
-template <typename T>
-Matrix2D<T> Sub(Matrix2D<T> lhs, Matrix2D<T> rhs) {
+template <typename T, typename LhsLayout, typename RhsLayout>
+Matrix2D<T, LhsLayout> Sub(Matrix2D<T, LhsLayout> lhs,
+                           Matrix2D<T, RhsLayout> rhs) {
+  // Only the by-value copies are counted here, the work is done by the
+  // nested MultScalar and Add which record themselves
+  CPP_MATRIX_PROFILE_OP(Sub, lhs.data().size(), 0,
+                        2 * lhs.data().size() * sizeof(T));
+
   auto negative_rhs = MultScalar(rhs, -1);
   auto result = Add(lhs, negative_rhs);
 
   return result;
 }
 
-template <typename T>
-Matrix2D<T> Transpose(const Matrix2D<T>& mat) {
+template <typename T, typename Layout>
+Matrix2D<T, Layout> Transpose(const Matrix2D<T, Layout>& mat) {
   using SizeType = Matrix2D<T>::SizeType;
   auto mat_shape = mat.shape();
   Shape2D<SizeType> new_shape = {mat_shape.cols, mat_shape.rows};
+  CPP_MATRIX_PROFILE_OP(Transpose, mat.data().size(), 0,
+                        mat.data().size() * sizeof(T));
 
-  auto result = Matrix2D<T>(new_shape);
+  auto result = Matrix2D<T, Layout>(new_shape);
 
-  for (SizeType row = 0; row < mat.rows(); row++) {
-    for (SizeType col = 0; col < mat.cols(); col++) {
-      result.get(col, row) = mat.get(row, col);
-    }
+  detail::TiledCopy<true, Layout, Layout>(mat.data().data(), mat_shape,
+                                          result.data().data());
+
+  return result;
+}
+
+// Same values, different storage order
+template <typename NewLayout, typename T, typename Layout>
+Matrix2D<T, NewLayout> ConvertLayout(const Matrix2D<T, Layout>& mat) {
+  CPP_MATRIX_PROFILE_OP(ConvertLayout, mat.data().size(), 0,
+                        mat.data().size() * sizeof(T));
+
+  auto result = Matrix2D<T, NewLayout>(mat.shape());
+
+  if constexpr (std::is_same_v<Layout, NewLayout>) {
+    result.data() = mat.data();
+  } else {
+    detail::TiledCopy<false, Layout, NewLayout>(
+        mat.data().data(), mat.shape(), result.data().data());
   }
 
   return result;
 }
 
-template <typename T>
-Matrix2D<T> DotProduct2D(const Matrix2D<T>& lhs, const Matrix2D<T>& rhs) {
+namespace detail {
+
+// Accumulates lhs * rhs into result, which must already have the product
+// shape and be zero-filled
+template <typename T, typename LhsLayout, typename RhsLayout>
+void DotProduct2DInto(const Matrix2D<T, LhsLayout>& lhs,
+                      const Matrix2D<T, RhsLayout>& rhs,
+                      Matrix2D<T, LhsLayout>& result) {
   using SizeType = Matrix2D<T>::SizeType;
   auto lhs_shape = lhs.shape();
   auto rhs_shape = rhs.shape();
+  auto result_shape = result.shape();
+
+  const T* a = lhs.data().data();
+  const T* b = rhs.data().data();
+  T* c = result.data().data();
+  SizeType n = lhs.cols();
+
+  auto A = [&](SizeType row, SizeType col) -> const T& {
+    return a[LhsLayout::Offset(lhs_shape, row, col)];
+  };
+  auto B = [&](SizeType row, SizeType col) -> const T& {
+    return b[RhsLayout::Offset(rhs_shape, row, col)];
+  };
+  auto C = [&](SizeType row, SizeType col) -> T& {
+    return c[LhsLayout::Offset(result_shape, row, col)];
+  };
+
+  // Loop order is picked so the innermost loop runs along storage order.
+  // Every element still sums over k in ascending order.
+  if constexpr (std::is_same_v<LhsLayout, ColMajor>) {
+    // j-k-i: columns of lhs and result are contiguous
+    for (SizeType j = 0; j < result.cols(); j++) {
+      for (SizeType k = 0; k < n; k++) {
+        T b_kj = B(k, j);
+
+        for (SizeType i = 0; i < result.rows(); i++) {
+          C(i, j) += A(i, k) * b_kj;
+        }
+      }
+    }
+  } else if constexpr (std::is_same_v<RhsLayout, ColMajor>) {
+    // i-j-k: lhs rows and rhs columns are contiguous
+    for (SizeType i = 0; i < result.rows(); i++) {
+      for (SizeType j = 0; j < result.cols(); j++) {
+        T sum = 0;
+
+        for (SizeType k = 0; k < n; k++) {
+          sum += A(i, k) * B(k, j);
+        }
+
+        C(i, j) = sum;
+      }
+    }
+  } else {
+    // i-k-j: rows of rhs and result are contiguous
+    for (SizeType i = 0; i < result.rows(); i++) {
+      for (SizeType k = 0; k < n; k++) {
+        T a_ik = A(i, k);
+
+        for (SizeType j = 0; j < result.cols(); j++) {
+          C(i, j) += a_ik * B(k, j);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+template <typename T, typename LhsLayout, typename RhsLayout>
+Matrix2D<T, LhsLayout> DotProduct2D(const Matrix2D<T, LhsLayout>& lhs,
+                                    const Matrix2D<T, RhsLayout>& rhs) {
+  auto lhs_shape = lhs.shape();
+  auto rhs_shape = rhs.shape();
 
   if (lhs_shape.cols != rhs_shape.rows) {
     std::string message =
@@ -244,26 +474,199 @@ Matrix2D<T> DotProduct2D(const Matrix2D<T>& lhs, const Matrix2D<T>& rhs) {
     throw ShapeMismatchException(message);
   }
   auto result_shape = Shape2D{lhs_shape.rows, rhs_shape.cols};
-  auto result = Matrix2D<T>(result_shape);
+  CPP_MATRIX_PROFILE_OP(
+      DotProduct2D, std::uint64_t(result_shape.rows) * result_shape.cols,
+      std::uint64_t(2) * result_shape.rows * result_shape.cols * lhs_shape.cols,
+      std::uint64_t(result_shape.rows) * result_shape.cols * sizeof(T));
 
-  for (SizeType i = 0; i < result.rows(); i++) {
-    for (SizeType j = 0; j < result.cols(); j++) {
-      SizeType n = lhs.cols();
-      T sum = 0;
+  auto result = Matrix2D<T, LhsLayout>(result_shape);
 
-      for (SizeType k = 0; k < n; k++) {
-        sum += lhs.get(i, k) * rhs.get(k, j);
-      }
+  detail::DotProduct2DInto(lhs, rhs, result);
 
-      result.get(i, j) = sum;
-    }
+  return result;
+}
+
+// Lazy elementwise expression. Map and ZipWith return one instead of a
+// matrix, so nesting them fuses every function into the single loop that
+// runs when the expression is converted to a Matrix2D (or Evaluate()d).
+// Operands are read by flat index, so they all share one layout.
+template <typename Layout, typename Function, typename... Operands>
+class ElementwiseExpr {
+ public:
+  using SizeType = int;
+  using LayoutType = Layout;
+  using ValueType = std::decay_t<std::invoke_result_t<
+      const Function&, typename Operands::ValueType...>>;
+
+  // Number of fused functions, used for the profiler's FLOP estimate
+  static constexpr std::size_t kFunctionCount =
+      1 + (Operands::kFunctionCount + ... + 0);
+
+ public:
+  ElementwiseExpr(Shape2D<SizeType> shape, Function function,
+                  Operands... operands)
+      : m_shape{shape},
+        m_function{std::move(function)},
+        m_operands{std::move(operands)...} {}
+
+  ValueType operator[](std::size_t i) const {
+    return std::apply(
+        [&](const auto&... operands) { return m_function(operands[i]...); },
+        m_operands);
+  }
+
+  auto rows() const { return m_shape.rows; }
+  auto cols() const { return m_shape.cols; }
+  auto shape() const { return m_shape; }
+
+  operator Matrix2D<ValueType, Layout>() const;
+
+ private:
+  Shape2D<SizeType> m_shape;
+  Function m_function;
+  std::tuple<Operands...> m_operands;
+};
+
+namespace detail {
+
+template <typename T>
+struct MatrixRefOperand {
+  using ValueType = T;
+  static constexpr std::size_t kFunctionCount = 0;
+
+  const std::vector<T>* data;
+
+  decltype(auto) operator[](std::size_t i) const { return (*data)[i]; }
+};
+
+// Temporaries are moved into the expression so it never dangles
+template <typename T, typename Layout>
+struct MatrixOwnedOperand {
+  using ValueType = T;
+  static constexpr std::size_t kFunctionCount = 0;
+
+  Matrix2D<T, Layout> matrix;
+
+  decltype(auto) operator[](std::size_t i) const { return matrix.data()[i]; }
+};
+
+template <typename T>
+struct ElementwiseOperand {};
+
+template <typename T, typename Layout>
+struct ElementwiseOperand<Matrix2D<T, Layout>> {
+  using LayoutType = Layout;
+
+  static auto Make(const Matrix2D<T, Layout>& matrix) {
+    return MatrixRefOperand<T>{&matrix.data()};
+  }
+  static auto Make(Matrix2D<T, Layout>&& matrix) {
+    return MatrixOwnedOperand<T, Layout>{std::move(matrix)};
+  }
+};
+
+template <typename Layout, typename Function, typename... Operands>
+struct ElementwiseOperand<ElementwiseExpr<Layout, Function, Operands...>> {
+  using LayoutType = Layout;
+
+  template <typename Expr>
+  static auto Make(Expr&& expr) {
+    return std::decay_t<Expr>(std::forward<Expr>(expr));
+  }
+};
+
+// Matrix2D or ElementwiseExpr
+template <typename T>
+concept Elementwise = requires(T&& value) {
+  ElementwiseOperand<std::remove_cvref_t<T>>::Make(std::forward<T>(value));
+};
+
+template <typename T>
+using ElementwiseLayout =
+    typename ElementwiseOperand<std::remove_cvref_t<T>>::LayoutType;
+
+template <typename T>
+auto MakeElementwiseOperand(T&& value) {
+  return ElementwiseOperand<std::remove_cvref_t<T>>::Make(
+      std::forward<T>(value));
+}
+
+}  // namespace detail
+
+// Lazy f(m[i]) for every element
+template <detail::Elementwise Operand, typename Function>
+auto Map(Operand&& operand, Function function) {
+  using Layout = detail::ElementwiseLayout<Operand>;
+  auto shape = operand.shape();
+  auto leaf = detail::MakeElementwiseOperand(std::forward<Operand>(operand));
+
+  return ElementwiseExpr<Layout, Function, decltype(leaf)>(
+      shape, std::move(function), std::move(leaf));
+}
+
+// Lazy f(lhs[i], rhs[i]) for every element
+template <detail::Elementwise Lhs, detail::Elementwise Rhs,
+          typename Function>
+auto ZipWith(Lhs&& lhs, Rhs&& rhs, Function function) {
+  using Layout = detail::ElementwiseLayout<Lhs>;
+  static_assert(std::is_same_v<Layout, detail::ElementwiseLayout<Rhs>>,
+                "ZipWith(): operands must share a layout, see ConvertLayout");
+
+  if (lhs.shape() != rhs.shape())
+    throw ShapeMismatchException("ZipWith(): Shape mismatch");
+
+  auto shape = lhs.shape();
+  auto lhs_leaf = detail::MakeElementwiseOperand(std::forward<Lhs>(lhs));
+  auto rhs_leaf = detail::MakeElementwiseOperand(std::forward<Rhs>(rhs));
+
+  return ElementwiseExpr<Layout, Function, decltype(lhs_leaf),
+                         decltype(rhs_leaf)>(
+      shape, std::move(function), std::move(lhs_leaf), std::move(rhs_leaf));
+}
+
+// Overloads taking a std::execution policy are in parallel.hpp
+template <typename Layout, typename Function, typename... Operands>
+Matrix2D<typename ElementwiseExpr<Layout, Function, Operands...>::ValueType,
+         Layout>
+Evaluate(const ElementwiseExpr<Layout, Function, Operands...>& expr) {
+  using Expr = ElementwiseExpr<Layout, Function, Operands...>;
+  using T = Expr::ValueType;
+
+  auto result = Matrix2D<T, Layout>(expr.shape());
+  auto& out = result.data();
+  CPP_MATRIX_PROFILE_OP(Evaluate, out.size(),
+                        out.size() * Expr::kFunctionCount,
+                        out.size() * sizeof(T));
+
+  for (std::size_t i = 0; i < out.size(); i++) {
+    out[i] = expr[i];
   }
 
   return result;
 }
 
-template <typename T, typename SizeType = typename Matrix2D<T>::SizeType>
-Matrix2D<T> Rand2D(Shape2D<SizeType> shape) {
+template <typename Layout, typename Function, typename... Operands>
+ElementwiseExpr<Layout, Function, Operands...>::operator Matrix2D<
+    ValueType, Layout>() const {
+  return Evaluate(*this);
+}
+
+// In place m[i] = f(m[i])
+template <typename T, typename Layout, typename Function>
+void Apply(Matrix2D<T, Layout>& matrix, Function function) {
+  CPP_MATRIX_PROFILE_OP(Apply, matrix.data().size(), matrix.data().size(), 0);
+
+  for (auto&& e : matrix.data()) {
+    e = function(e);
+  }
+}
+
+template <typename T, typename Layout = RowMajor,
+          typename SizeType = typename Matrix2D<T>::SizeType>
+Matrix2D<T, Layout> Rand2D(Shape2D<SizeType> shape) {
+  CPP_MATRIX_PROFILE_OP(Rand2D, std::uint64_t(shape.rows) * shape.cols, 0,
+                        std::uint64_t(shape.rows) * shape.cols * sizeof(T));
+
   std::random_device rd;
   std::minstd_rand engine(rd());
   std::uniform_int_distribution<int> distribution(1, 9);
@@ -271,7 +674,7 @@ Matrix2D<T> Rand2D(Shape2D<SizeType> shape) {
     return distribution(engine);
   };
 
-  auto result = Matrix2D<T>(shape);
+  auto result = Matrix2D<T, Layout>(shape);
 
   for (SizeType row = 0; row < result.rows(); row++) {
     for (SizeType col = 0; col < result.cols(); col++) {
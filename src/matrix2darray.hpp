@@ -12,7 +12,7 @@ template <typename T, std::size_t ROWS = 0, std::size_t COLS = 0>
 class Matrix2DArray {
  public:
   using SizeType = std::size_t;
-  Matrix2DArray(T init_value = {}) : m_data{} {
+  constexpr Matrix2DArray(T init_value = {}) : m_data{} {
     for (auto& row : m_data) {
       row.fill(init_value);
     }
@@ -22,8 +22,38 @@ class Matrix2DArray {
     return m_data[row][col];
   }
 
+  [[nodiscard]] constexpr const T& get(SizeType row, SizeType col) const {
+    return m_data[row][col];
+  }
+
+  static constexpr SizeType rows() { return ROWS; }
+  static constexpr SizeType cols() { return COLS; }
+
+  bool operator==(const Matrix2DArray&) const = default;
+
  private:
   std::array<std::array<T, COLS>, ROWS> m_data;
 };
+
+// Inner dimensions are checked at compile time
+template <typename T, std::size_t ROWS, std::size_t N, std::size_t COLS>
+constexpr Matrix2DArray<T, ROWS, COLS> DotProduct2D(
+    const Matrix2DArray<T, ROWS, N>& lhs,
+    const Matrix2DArray<T, N, COLS>& rhs) {
+  using SizeType = Matrix2DArray<T, ROWS, COLS>::SizeType;
+  auto result = Matrix2DArray<T, ROWS, COLS>();
+
+  for (SizeType i = 0; i < ROWS; i++) {
+    for (SizeType k = 0; k < N; k++) {
+      T a_ik = lhs.get(i, k);
+
+      for (SizeType j = 0; j < COLS; j++) {
+        result.get(i, j) += a_ik * rhs.get(k, j);
+      }
+    }
+  }
+
+  return result;
+}
 }  // namespace cpp_matrix
 }  // namespace qustrolabe
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <stdexcept>
+#include <type_traits>
+#include <version>
+
+#include "matrix2d.hpp"
+
+#ifdef __cpp_lib_mdspan
+#include <mdspan>
+#endif
+
+namespace qustrolabe {
+namespace cpp_matrix {
+
+// Non-owning view over strided 2D data: a Matrix2D of either layout,
+// a raw Fortran/column-major buffer or any 2D std::mdspan.
+// Use const T for a read-only view.
+template <typename T>
+class Matrix2DView {
+ public:
+  using SizeType = int;
+  using ValueType = std::remove_const_t<T>;
+
+ public:
+  Matrix2DView(T* data, Shape2D<SizeType> shape, SizeType row_stride,
+               SizeType col_stride)
+      : m_data{data},
+        m_shape{shape},
+        m_row_stride{row_stride},
+        m_col_stride{col_stride} {}
+
+  template <typename Layout>
+  Matrix2DView(Matrix2D<ValueType, Layout>& matrix)
+      : Matrix2DView(matrix.data().data(), matrix.shape(),
+                     Layout::Offset(matrix.shape(), 1, 0),
+                     Layout::Offset(matrix.shape(), 0, 1)) {}
+
+  template <typename Layout>
+    requires std::is_const_v<T>
+  Matrix2DView(const Matrix2D<ValueType, Layout>& matrix)
+      : Matrix2DView(matrix.data().data(), matrix.shape(),
+                     Layout::Offset(matrix.shape(), 1, 0),
+                     Layout::Offset(matrix.shape(), 0, 1)) {}
+
+#ifdef __cpp_lib_mdspan
+  template <typename Extents, typename MdspanLayout>
+    requires(Extents::rank() == 2)
+  Matrix2DView(std::mdspan<T, Extents, MdspanLayout> span)
+      : Matrix2DView(span.data_handle(),
+                     Shape2D{static_cast<SizeType>(span.extent(0)),
+                             static_cast<SizeType>(span.extent(1))},
+                     static_cast<SizeType>(span.stride(0)),
+                     static_cast<SizeType>(span.stride(1))) {}
+
+  auto mdspan() const {
+    using Extents = std::dextents<SizeType, 2>;
+    using Mapping = std::layout_stride::mapping<Extents>;
+
+    auto extents = Extents(m_shape.rows, m_shape.cols);
+    auto strides = std::array<SizeType, 2>{m_row_stride, m_col_stride};
+    return std::mdspan<T, Extents, std::layout_stride>(
+        m_data, Mapping(extents, strides));
+  }
+#endif
+
+  T& get(SizeType row, SizeType col) const {
+    if (row < 0 or row >= m_shape.rows) throw std::out_of_range("Out of row");
+    if (col < 0 or col >= m_shape.cols) throw std::out_of_range("Out of col");
+
+    return m_data[row * m_row_stride + col * m_col_stride];
+  }
+
+  auto rows() const { return m_shape.rows; }
+  auto cols() const { return m_shape.cols; }
+  auto shape() const { return m_shape; }
+  auto rowStride() const { return m_row_stride; }
+  auto colStride() const { return m_col_stride; }
+
+  T* data() const { return m_data; }
+
+ private:
+  T* m_data;
+  Shape2D<SizeType> m_shape;
+  SizeType m_row_stride;
+  SizeType m_col_stride;
+};
+
+template <typename T, typename Layout>
+Matrix2DView(Matrix2D<T, Layout>&) -> Matrix2DView<T>;
+
+template <typename T, typename Layout>
+Matrix2DView(const Matrix2D<T, Layout>&) -> Matrix2DView<const T>;
+
+// Copies a view into owning storage of the requested layout
+template <typename Layout = RowMajor, typename T>
+Matrix2D<std::remove_const_t<T>, Layout> ToMatrix2D(Matrix2DView<T> view) {
+  using SizeType = Matrix2DView<T>::SizeType;
+
+  auto shape = view.shape();
+  auto result = Matrix2D<std::remove_const_t<T>, Layout>(shape);
+  auto* out = result.data().data();
+  const T* in = view.data();
+
+  detail::ForEachInStorageOrder<Layout>(
+      shape, [&](SizeType row, SizeType col) {
+        out[Layout::Offset(shape, row, col)] =
+            in[row * view.rowStride() + col * view.colStride()];
+      });
+
+  return result;
+}
+
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
@@ -0,0 +1,318 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <list>
+#include <map>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "matrix2d.hpp"
+#include "matrix2darray.hpp"
+
+namespace qustrolabe {
+namespace cpp_matrix {
+
+// Multiplication order for a chain of matrices, plus the intermediate
+// buffers it needs
+struct ChainPlan {
+  // lhs and rhs index operands: values below the chain length are inputs,
+  // chain length + s is the product of step s
+  struct Step {
+    std::size_t lhs;
+    std::size_t rhs;
+    std::size_t buffer;
+  };
+
+  std::vector<Step> steps;
+  // Capacity each buffer needs, a buffer is reused once its value has been
+  // consumed. The last step's buffer holds the result.
+  std::vector<std::uint64_t> buffer_elements;
+  // Scalar multiplications of the whole chain in this order
+  std::uint64_t multiplications = 0;
+};
+
+namespace detail {
+
+// Classic O(n^3) matrix chain order DP. Matrix i is dims[i] x dims[i + 1].
+// Fills split[i][j] with the k for which (i..k)(k+1..j) is cheapest and
+// returns the cost of the whole chain. Shared by the runtime planner and
+// the compile-time Matrix2DArray version.
+template <typename Dims, typename Table>
+constexpr std::uint64_t SolveChainOrder(const Dims& dims, std::size_t count,
+                                        Table& cost, Table& split) {
+  for (std::size_t length = 2; length <= count; length++) {
+    for (std::size_t i = 0; i + length - 1 < count; i++) {
+      std::size_t j = i + length - 1;
+      cost[i][j] = std::numeric_limits<std::uint64_t>::max();
+
+      for (std::size_t k = i; k < j; k++) {
+        std::uint64_t candidate = cost[i][k] + cost[k + 1][j] +
+                                  dims[i] * dims[k + 1] * dims[j + 1];
+        if (candidate < cost[i][j]) {
+          cost[i][j] = candidate;
+          split[i][j] = k;
+        }
+      }
+    }
+  }
+
+  return cost[0][count - 1];
+}
+
+// Appends the steps for (i..j) in post-order, returns the operand index
+// holding their product
+template <typename Table>
+std::size_t EmitChainSteps(const Table& split, std::size_t i, std::size_t j,
+                           std::size_t count,
+                           std::vector<ChainPlan::Step>& steps) {
+  if (i == j) return i;
+
+  auto k = static_cast<std::size_t>(split[i][j]);
+  std::size_t lhs = EmitChainSteps(split, i, k, count, steps);
+  std::size_t rhs = EmitChainSteps(split, k + 1, j, count, steps);
+
+  steps.push_back({lhs, rhs, 0});
+  return count + steps.size() - 1;
+}
+
+}  // namespace detail
+
+inline ChainPlan PlanChain(const std::vector<Shape2D<int>>& shapes) {
+  if (shapes.empty()) {
+    throw std::invalid_argument("PlanChain(): empty chain");
+  }
+
+  std::size_t count = shapes.size();
+  std::vector<std::uint64_t> dims{static_cast<std::uint64_t>(shapes[0].rows)};
+
+  for (std::size_t i = 0; i < count; i++) {
+    if (i + 1 < count and shapes[i].cols != shapes[i + 1].rows) {
+      std::string message = std::format(
+          "ShapeMismatchException: chain link {}: {}x{} dot {}x{}", i,
+          shapes[i].rows, shapes[i].cols, shapes[i + 1].rows,
+          shapes[i + 1].cols);
+      throw ShapeMismatchException(message);
+    }
+    dims.push_back(static_cast<std::uint64_t>(shapes[i].cols));
+  }
+
+  auto cost = std::vector(count, std::vector<std::uint64_t>(count, 0));
+  auto split = cost;
+
+  ChainPlan plan{};
+  plan.multiplications = detail::SolveChainOrder(dims, count, cost, split);
+  detail::EmitChainSteps(split, 0, count - 1, count, plan.steps);
+
+  // Assign buffers: the output buffer is picked before the inputs are
+  // released, so a step never writes over one of its own operands
+  std::vector<Shape2D<int>> operand_shapes = shapes;
+  std::vector<std::size_t> operand_buffer(count + plan.steps.size());
+  std::vector<std::size_t> free_buffers{};
+
+  for (std::size_t s = 0; s < plan.steps.size(); s++) {
+    auto& step = plan.steps[s];
+    auto shape = Shape2D{operand_shapes[step.lhs].rows,
+                         operand_shapes[step.rhs].cols};
+    auto elements = static_cast<std::uint64_t>(shape.rows) * shape.cols;
+
+    if (free_buffers.empty()) {
+      step.buffer = plan.buffer_elements.size();
+      plan.buffer_elements.push_back(elements);
+    } else {
+      step.buffer = free_buffers.back();
+      free_buffers.pop_back();
+      plan.buffer_elements[step.buffer] =
+          std::max(plan.buffer_elements[step.buffer], elements);
+    }
+
+    for (std::size_t operand : {step.lhs, step.rhs}) {
+      if (operand >= count) free_buffers.push_back(operand_buffer[operand]);
+    }
+
+    operand_shapes.push_back(shape);
+    operand_buffer[count + s] = step.buffer;
+  }
+
+  return plan;
+}
+
+// Plans keyed by the sequence of shapes, evicting the least recently used
+// one past capacity so long-running processes with many distinct chains
+// stay bounded
+class ChainPlanCache {
+ public:
+  explicit ChainPlanCache(std::size_t capacity) : m_capacity{capacity} {}
+
+  // Valid until the next get() or clear() on this cache
+  const ChainPlan& get(const std::vector<Shape2D<int>>& shapes) {
+    auto it = m_index.find(shapes);
+    if (it != m_index.end()) {
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return it->second->second;
+    }
+
+    // Planned first, so a mismatched chain leaves the cache untouched
+    auto plan = PlanChain(shapes);
+    m_entries.emplace_front(shapes, std::move(plan));
+    m_index.emplace(shapes, m_entries.begin());
+
+    if (m_entries.size() > std::max<std::size_t>(m_capacity, 1)) {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+
+    return m_entries.front().second;
+  }
+
+  void clear() {
+    m_index.clear();
+    m_entries.clear();
+  }
+
+  auto size() const { return m_entries.size(); }
+  auto capacity() const { return m_capacity; }
+
+ private:
+  using Entry = std::pair<std::vector<Shape2D<int>>, ChainPlan>;
+
+  std::size_t m_capacity;
+  // Most recently used first
+  std::list<Entry> m_entries;
+  std::map<std::vector<Shape2D<int>>, std::list<Entry>::iterator> m_index;
+};
+
+// Cache used by MultiplyChain on the calling thread
+inline ChainPlanCache& LocalChainPlanCache() {
+  thread_local ChainPlanCache cache(64);
+  return cache;
+}
+
+inline const ChainPlan& CachedChainPlan(
+    const std::vector<Shape2D<int>>& shapes) {
+  return LocalChainPlanCache().get(shapes);
+}
+
+namespace detail {
+
+template <typename T, typename Layout>
+Matrix2D<T, Layout> ExecuteChain(
+    std::span<const Matrix2D<T, Layout>* const> operands) {
+  if (operands.empty()) {
+    throw std::invalid_argument("MultiplyChain(): empty chain");
+  }
+  if (operands.size() == 1) return *operands[0];
+
+  std::vector<Shape2D<int>> shapes{};
+  shapes.reserve(operands.size());
+  for (const auto* operand : operands) {
+    shapes.push_back(operand->shape());
+  }
+
+  const auto& plan = CachedChainPlan(shapes);
+  CPP_MATRIX_PROFILE_OP(
+      MultiplyChain, std::uint64_t(shapes.front().rows) * shapes.back().cols,
+      2 * plan.multiplications,
+      std::accumulate(plan.buffer_elements.begin(),
+                      plan.buffer_elements.end(), std::uint64_t{0}) *
+          sizeof(T));
+
+  // One allocation per buffer, sized for the largest value it will hold
+  std::vector<Matrix2D<T, Layout>> buffers{};
+  buffers.reserve(plan.buffer_elements.size());
+  for (auto elements : plan.buffer_elements) {
+    buffers.emplace_back(Shape2D{0, 0});
+    buffers.back().data().reserve(elements);
+  }
+
+  std::vector<const Matrix2D<T, Layout>*> values(operands.begin(),
+                                                 operands.end());
+  for (const auto& step : plan.steps) {
+    const auto& lhs = *values[step.lhs];
+    const auto& rhs = *values[step.rhs];
+    auto& out = buffers[step.buffer];
+
+    out.resize(Shape2D{lhs.rows(), rhs.cols()});
+    DotProduct2DInto(lhs, rhs, out);
+    values.push_back(&out);
+  }
+
+  return std::move(buffers[plan.steps.back().buffer]);
+}
+
+}  // namespace detail
+
+// Multiplies a * b * c * ... in the order with the fewest scalar
+// multiplications
+template <typename T, typename Layout, typename... Rest>
+  requires(std::is_same_v<Rest, Matrix2D<T, Layout>> and ...)
+Matrix2D<T, Layout> MultiplyChain(const Matrix2D<T, Layout>& first,
+                                  const Rest&... rest) {
+  auto operands = std::array<const Matrix2D<T, Layout>*, 1 + sizeof...(Rest)>{
+      &first, &rest...};
+
+  return detail::ExecuteChain<T, Layout>(operands);
+}
+
+template <typename T, typename Layout>
+Matrix2D<T, Layout> MultiplyChain(
+    const std::vector<Matrix2D<T, Layout>>& chain) {
+  std::vector<const Matrix2D<T, Layout>*> operands{};
+  operands.reserve(chain.size());
+  for (const auto& matrix : chain) {
+    operands.push_back(&matrix);
+  }
+
+  return detail::ExecuteChain<T, Layout>(operands);
+}
+
+namespace detail {
+
+template <std::size_t... Dims>
+struct StaticChainOrder {
+  static constexpr std::size_t kCount = sizeof...(Dims) - 1;
+
+  static constexpr auto kSplit = [] {
+    std::array<std::uint64_t, sizeof...(Dims)> dims{Dims...};
+    std::array<std::array<std::uint64_t, kCount>, kCount> cost{};
+    std::array<std::array<std::uint64_t, kCount>, kCount> split{};
+
+    if constexpr (kCount > 1) SolveChainOrder(dims, kCount, cost, split);
+    return split;
+  }();
+};
+
+template <std::size_t I, std::size_t J, typename Order, typename Operands>
+constexpr decltype(auto) MultiplyStaticRange(const Operands& operands) {
+  if constexpr (I == J) {
+    return std::get<I>(operands);
+  } else {
+    constexpr auto k = static_cast<std::size_t>(Order::kSplit[I][J]);
+    return DotProduct2D(MultiplyStaticRange<I, k, Order>(operands),
+                        MultiplyStaticRange<k + 1, J, Order>(operands));
+  }
+}
+
+}  // namespace detail
+
+// Compile-time variant: the order is solved from the template dimensions
+// and mismatched inner dimensions fail to compile
+template <typename T, std::size_t ROWS, std::size_t COLS, typename... Rest>
+constexpr auto MultiplyChain(const Matrix2DArray<T, ROWS, COLS>& first,
+                             const Rest&... rest) {
+  using Order = detail::StaticChainOrder<ROWS, COLS, Rest::cols()...>;
+
+  return detail::MultiplyStaticRange<0, sizeof...(Rest), Order>(
+      std::tie(first, rest...));
+}
+
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
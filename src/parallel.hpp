@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "matrix2d.hpp"
+
+// std::execution policy overloads of Evaluate and Apply. Not included by
+// cpp_matrix.hpp: with libstdc++ and TBB headers installed, <execution>
+// makes every translation unit that includes it link against TBB.
+
+namespace qustrolabe {
+namespace cpp_matrix {
+
+namespace detail {
+
+// Runs body(begin, end) over [0, size) in blocks spread by the policy. The
+// blocks carry their own begin index, so nothing depends on the addresses
+// of the elements the algorithm hands out.
+template <typename ExecutionPolicy, typename Body>
+void ForEachBlock(ExecutionPolicy&& policy, std::size_t size, Body body) {
+  constexpr std::size_t kBlock = 4096;
+
+  std::vector<std::size_t> blocks{};
+  blocks.reserve(size / kBlock + 1);
+  for (std::size_t begin = 0; begin < size; begin += kBlock) {
+    blocks.push_back(begin);
+  }
+
+  std::for_each(std::forward<ExecutionPolicy>(policy), blocks.begin(),
+                blocks.end(), [&](std::size_t begin) {
+                  body(begin, std::min(begin + kBlock, size));
+                });
+}
+
+}  // namespace detail
+
+// Evaluate() with the loop split by a std::execution policy
+template <typename ExecutionPolicy, typename Layout, typename Function,
+          typename... Operands>
+  requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+Matrix2D<typename ElementwiseExpr<Layout, Function, Operands...>::ValueType,
+         Layout>
+Evaluate(ExecutionPolicy&& policy,
+         const ElementwiseExpr<Layout, Function, Operands...>& expr) {
+  using Expr = ElementwiseExpr<Layout, Function, Operands...>;
+  using T = Expr::ValueType;
+
+  if constexpr (std::is_same_v<T, bool>) {
+    // Neighbouring std::vector<bool> elements share a word
+    return Evaluate(expr);
+  } else {
+    auto result = Matrix2D<T, Layout>(expr.shape());
+    auto& out = result.data();
+    CPP_MATRIX_PROFILE_OP(Evaluate, out.size(),
+                          out.size() * Expr::kFunctionCount,
+                          out.size() * sizeof(T));
+
+    detail::ForEachBlock(std::forward<ExecutionPolicy>(policy), out.size(),
+                         [&](std::size_t begin, std::size_t end) {
+                           for (std::size_t i = begin; i < end; i++) {
+                             out[i] = expr[i];
+                           }
+                         });
+
+    return result;
+  }
+}
+
+// Apply() with the loop split by a std::execution policy
+template <typename ExecutionPolicy, typename T, typename Layout,
+          typename Function>
+  requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+void Apply(ExecutionPolicy&& policy, Matrix2D<T, Layout>& matrix,
+           Function function) {
+  if constexpr (std::is_same_v<T, bool>) {
+    Apply(matrix, std::move(function));
+  } else {
+    auto& data = matrix.data();
+    CPP_MATRIX_PROFILE_OP(Apply, data.size(), data.size(), 0);
+
+    detail::ForEachBlock(std::forward<ExecutionPolicy>(policy), data.size(),
+                         [&](std::size_t begin, std::size_t end) {
+                           for (std::size_t i = begin; i < end; i++) {
+                             data[i] = function(data[i]);
+                           }
+                         });
+  }
+}
+
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
@@ -0,0 +1,416 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Operation profiling for matrix2d.hpp.
+//
+// Define CPP_MATRIX_PROFILING before including the library (or pass it as a
+// compile definition to every translation unit) to record per-op call,
+// element, FLOP, allocation and wall time counters. Without it
+// CPP_MATRIX_PROFILE_OP expands to nothing and no counters are touched.
+//
+// Each thread writes only to its own counters and trace buffer, so the
+// hot path takes no locks. A mutex is taken once per thread on first use
+// and on exit, and by TakeSnapshot()/ExportChromeTrace()/Reset(). A new
+// thread may continue the counters and trace of one that has exited.
+
+#ifndef CPP_MATRIX_PROFILING_TRACE_CAPACITY
+#define CPP_MATRIX_PROFILING_TRACE_CAPACITY 4096
+#endif
+
+#ifdef CPP_MATRIX_PROFILING
+#define CPP_MATRIX_PROFILE_OP(op, elements, flops, bytes)        \
+  ::qustrolabe::cpp_matrix::profiling::ScopedOp cpp_matrix_op_ { \
+    ::qustrolabe::cpp_matrix::profiling::Op::op,                 \
+        static_cast<std::uint64_t>(elements),                    \
+        static_cast<std::uint64_t>(flops),                       \
+        static_cast<std::uint64_t>(bytes)                        \
+  }
+#else
+#define CPP_MATRIX_PROFILE_OP(op, elements, flops, bytes) static_cast<void>(0)
+#endif
+
+namespace qustrolabe {
+namespace cpp_matrix {
+namespace profiling {
+
+enum class Op : std::size_t {
+  Add,
+  AddScalar,
+  MultScalar,
+  Sub,
+  Transpose,
+  ConvertLayout,
+  DotProduct2D,
+  MultiplyChain,
+  StrassenDotProduct2D,
+  Evaluate,
+  Apply,
+  Rand2D,
+  Count
+};
+
+constexpr std::size_t kOpCount = static_cast<std::size_t>(Op::Count);
+
+constexpr std::string_view OpName(Op op) {
+  constexpr std::array<std::string_view, kOpCount> names{
+      "Add",
+      "AddScalar",
+      "MultScalar",
+      "Sub",
+      "Transpose",
+      "ConvertLayout",
+      "DotProduct2D",
+      "MultiplyChain",
+      "StrassenDotProduct2D",
+      "Evaluate",
+      "Apply",
+      "Rand2D"};
+  return names[static_cast<std::size_t>(op)];
+}
+
+struct OpStats {
+  std::uint64_t calls = 0;
+  std::uint64_t elements = 0;
+  std::uint64_t flops = 0;
+  std::uint64_t bytes_allocated = 0;
+  std::uint64_t nanoseconds = 0;
+
+  OpStats& operator+=(const OpStats& other) {
+    calls += other.calls;
+    elements += other.elements;
+    flops += other.flops;
+    bytes_allocated += other.bytes_allocated;
+    nanoseconds += other.nanoseconds;
+    return *this;
+  }
+
+  bool operator==(const OpStats&) const = default;
+};
+
+// Counters of one profile slot. Slots of exited threads are reused, so
+// an entry can add up several threads that ran one after another; only
+// threads alive at the same time are guaranteed separate entries.
+struct ThreadSnapshot {
+  std::uint32_t thread_index;
+  std::array<OpStats, kOpCount> ops;
+  std::uint64_t dropped_events;
+
+  const OpStats& operator[](Op op) const {
+    return ops[static_cast<std::size_t>(op)];
+  }
+};
+
+struct Snapshot {
+  std::vector<ThreadSnapshot> threads;
+
+  // Sum over all threads
+  OpStats Total(Op op) const {
+    OpStats result{};
+    for (const auto& thread : threads) {
+      result += thread[op];
+    }
+    return result;
+  }
+};
+
+struct TraceEvent {
+  Op op;
+  std::uint64_t start_ns;  // since the first recorded op in the process
+  std::uint64_t duration_ns;
+  std::uint64_t elements;
+  std::uint64_t flops;
+  std::uint64_t bytes_allocated;
+};
+
+namespace detail {
+
+using Clock = std::chrono::steady_clock;
+
+// Written by the owning thread only, read by TakeSnapshot()
+struct AtomicOpStats {
+  std::atomic<std::uint64_t> calls{0};
+  std::atomic<std::uint64_t> elements{0};
+  std::atomic<std::uint64_t> flops{0};
+  std::atomic<std::uint64_t> bytes_allocated{0};
+  std::atomic<std::uint64_t> nanoseconds{0};
+};
+
+// Single writer, so a relaxed load + store is enough and avoids a locked RMW
+inline void Bump(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+struct ThreadProfile {
+  explicit ThreadProfile(std::uint32_t index)
+      : thread_index{index},
+        events{std::make_unique<TraceEvent[]>(
+            CPP_MATRIX_PROFILING_TRACE_CAPACITY)} {}
+
+  std::uint32_t thread_index;
+  std::array<AtomicOpStats, kOpCount> ops;
+
+  // Append-only buffer: event_count is published after the event is
+  // written. Once full, events are dropped and counted until Reset().
+  std::unique_ptr<TraceEvent[]> events;
+  std::atomic<std::size_t> event_count{0};
+  std::atomic<std::uint64_t> dropped_events{0};
+};
+
+// Owns every ThreadProfile for the life of the process so counters of
+// finished threads still show up in snapshots. Profiles of exited threads
+// are handed to new ones, so the count is bounded by the peak number of
+// live threads rather than by every thread ever started.
+class Registry {
+ public:
+  static Registry& Instance() {
+    static Registry registry;
+    return registry;
+  }
+
+  ThreadProfile& Acquire() {
+    std::lock_guard lock(m_mutex);
+    if (!m_free.empty()) {
+      auto* profile = m_free.back();
+      m_free.pop_back();
+      return *profile;
+    }
+
+    auto index = static_cast<std::uint32_t>(m_profiles.size());
+    m_profiles.push_back(std::make_unique<ThreadProfile>(index));
+    return *m_profiles.back();
+  }
+
+  void Release(ThreadProfile& profile) {
+    std::lock_guard lock(m_mutex);
+    m_free.push_back(&profile);
+  }
+
+  template <typename Function>
+  void ForEach(Function&& function) {
+    std::lock_guard lock(m_mutex);
+    for (auto& profile : m_profiles) {
+      function(*profile);
+    }
+  }
+
+  Clock::time_point epoch() const { return m_epoch; }
+
+ private:
+  Registry() : m_epoch{Clock::now()} {}
+
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<ThreadProfile>> m_profiles;
+  std::vector<ThreadProfile*> m_free;
+  Clock::time_point m_epoch;
+};
+
+// Holds a thread's profile and returns it to the registry on thread exit
+class ProfileLease {
+ public:
+  ProfileLease() : m_profile{Registry::Instance().Acquire()} {}
+  ~ProfileLease() { Registry::Instance().Release(m_profile); }
+
+  ProfileLease(const ProfileLease&) = delete;
+  ProfileLease& operator=(const ProfileLease&) = delete;
+
+  ThreadProfile& profile() const { return m_profile; }
+
+ private:
+  ThreadProfile& m_profile;
+};
+
+inline ThreadProfile& LocalProfile() {
+  thread_local ProfileLease lease;
+  return lease.profile();
+}
+
+}  // namespace detail
+
+// Records one op from construction to destruction
+class ScopedOp {
+ public:
+  ScopedOp(Op op, std::uint64_t elements, std::uint64_t flops,
+           std::uint64_t bytes_allocated)
+      : m_op{op},
+        m_elements{elements},
+        m_flops{flops},
+        m_bytes_allocated{bytes_allocated},
+        m_profile{detail::LocalProfile()},
+        m_start{detail::Clock::now()} {}
+
+  ScopedOp(const ScopedOp&) = delete;
+  ScopedOp& operator=(const ScopedOp&) = delete;
+
+  ~ScopedOp() {
+    auto end = detail::Clock::now();
+    auto& profile = m_profile;
+    auto& stats = profile.ops[static_cast<std::size_t>(m_op)];
+    auto duration = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start)
+            .count());
+
+    detail::Bump(stats.calls, 1);
+    detail::Bump(stats.elements, m_elements);
+    detail::Bump(stats.flops, m_flops);
+    detail::Bump(stats.bytes_allocated, m_bytes_allocated);
+    detail::Bump(stats.nanoseconds, duration);
+
+    auto count = profile.event_count.load(std::memory_order_relaxed);
+    if (count == CPP_MATRIX_PROFILING_TRACE_CAPACITY) {
+      detail::Bump(profile.dropped_events, 1);
+      return;
+    }
+
+    auto since_epoch = m_start - detail::Registry::Instance().epoch();
+    profile.events[count] = TraceEvent{
+        m_op,
+        static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch)
+                .count()),
+        duration,
+        m_elements,
+        m_flops,
+        m_bytes_allocated};
+    profile.event_count.store(count + 1, std::memory_order_release);
+  }
+
+ private:
+  Op m_op;
+  std::uint64_t m_elements;
+  std::uint64_t m_flops;
+  std::uint64_t m_bytes_allocated;
+  // Taken before m_start so the registry, and with it the trace epoch,
+  // exists before the first op starts timing
+  detail::ThreadProfile& m_profile;
+  detail::Clock::time_point m_start;
+};
+
+inline Snapshot TakeSnapshot() {
+  Snapshot result{};
+
+  detail::Registry::Instance().ForEach([&](detail::ThreadProfile& profile) {
+    ThreadSnapshot thread{};
+    thread.thread_index = profile.thread_index;
+    thread.dropped_events =
+        profile.dropped_events.load(std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < kOpCount; i++) {
+      const auto& stats = profile.ops[i];
+      thread.ops[i] = OpStats{
+          stats.calls.load(std::memory_order_relaxed),
+          stats.elements.load(std::memory_order_relaxed),
+          stats.flops.load(std::memory_order_relaxed),
+          stats.bytes_allocated.load(std::memory_order_relaxed),
+          stats.nanoseconds.load(std::memory_order_relaxed)};
+    }
+
+    result.threads.push_back(thread);
+  });
+
+  return result;
+}
+
+// Zeroes every counter and drops recorded events. Only call it while no
+// other thread is running matrix ops.
+inline void Reset() {
+  detail::Registry::Instance().ForEach([](detail::ThreadProfile& profile) {
+    for (auto& stats : profile.ops) {
+      stats.calls.store(0, std::memory_order_relaxed);
+      stats.elements.store(0, std::memory_order_relaxed);
+      stats.flops.store(0, std::memory_order_relaxed);
+      stats.bytes_allocated.store(0, std::memory_order_relaxed);
+      stats.nanoseconds.store(0, std::memory_order_relaxed);
+    }
+    profile.dropped_events.store(0, std::memory_order_relaxed);
+    profile.event_count.store(0, std::memory_order_release);
+  });
+}
+
+// Per-thread counters as JSON:
+// {"threads":[{"thread":0,"dropped_events":0,"ops":{"Add":{...},...}}]}
+inline std::string ExportJson(const Snapshot& snapshot) {
+  auto stats_json = [](const OpStats& stats) {
+    return "{\"calls\":" + std::to_string(stats.calls) +
+           ",\"elements\":" + std::to_string(stats.elements) +
+           ",\"flops\":" + std::to_string(stats.flops) +
+           ",\"bytes_allocated\":" + std::to_string(stats.bytes_allocated) +
+           ",\"nanoseconds\":" + std::to_string(stats.nanoseconds) + "}";
+  };
+
+  std::string json = "{\"threads\":[";
+  for (std::size_t t = 0; t < snapshot.threads.size(); t++) {
+    const auto& thread = snapshot.threads[t];
+    if (t != 0) json += ",";
+
+    json += "{\"thread\":" + std::to_string(thread.thread_index) +
+            ",\"dropped_events\":" + std::to_string(thread.dropped_events) +
+            ",\"ops\":{";
+
+    bool first = true;
+    for (std::size_t i = 0; i < kOpCount; i++) {
+      if (thread.ops[i].calls == 0) continue;
+      if (!first) json += ",";
+      first = false;
+
+      json += "\"";
+      json += OpName(static_cast<Op>(i));
+      json += "\":" + stats_json(thread.ops[i]);
+    }
+    json += "}}";
+  }
+  json += "]}";
+
+  return json;
+}
+
+// Recorded events in the Chrome trace event format, loadable in
+// chrome://tracing or Perfetto
+inline std::string ExportChromeTrace() {
+  // integer nanoseconds printed as fractional microseconds
+  auto microseconds = [](std::uint64_t ns) {
+    auto fraction = std::to_string(ns % 1000);
+    return std::to_string(ns / 1000) + "." +
+           std::string(3 - fraction.size(), '0') + fraction;
+  };
+
+  std::string json = "{\"traceEvents\":[";
+  bool first = true;
+
+  detail::Registry::Instance().ForEach([&](detail::ThreadProfile& profile) {
+    auto count = profile.event_count.load(std::memory_order_acquire);
+
+    for (std::size_t i = 0; i < count; i++) {
+      const auto& event = profile.events[i];
+      if (!first) json += ",";
+      first = false;
+
+      json += "{\"name\":\"";
+      json += OpName(event.op);
+      json += "\",\"cat\":\"cpp_matrix\",\"ph\":\"X\",\"pid\":0";
+      json += ",\"tid\":" + std::to_string(profile.thread_index);
+      json += ",\"ts\":" + microseconds(event.start_ns);
+      json += ",\"dur\":" + microseconds(event.duration_ns);
+      json += ",\"args\":{\"elements\":" + std::to_string(event.elements) +
+              ",\"flops\":" + std::to_string(event.flops) +
+              ",\"bytes_allocated\":" +
+              std::to_string(event.bytes_allocated) + "}}";
+    }
+  });
+  json += "],\"displayTimeUnit\":\"ns\"}";
+
+  return json;
+}
+
+}  // namespace profiling
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
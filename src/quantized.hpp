@@ -0,0 +1,462 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "matrix2d.hpp"
+
+namespace qustrolabe {
+namespace cpp_matrix {
+
+// IEEE 754 binary16 storage type. Arithmetic and comparisons go through
+// float, compare bits() for bitwise equality.
+class Float16 {
+ public:
+  constexpr Float16() = default;
+  constexpr Float16(float value) : m_bits(FromFloat(value)) {}
+
+  static constexpr Float16 FromBits(std::uint16_t bits) {
+    Float16 result;
+    result.m_bits = bits;
+    return result;
+  }
+
+  constexpr operator float() const { return ToFloat(m_bits); }
+
+  constexpr std::uint16_t bits() const { return m_bits; }
+
+ private:
+  // Round-to-nearest-even, overflow goes to infinity.
+  static constexpr std::uint16_t FromFloat(float value) {
+    auto bits = std::bit_cast<std::uint32_t>(value);
+    auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    std::uint32_t abs = bits & 0x7fffffff;
+
+    if (abs >= 0x7f800000) {  // inf or nan
+      return sign | 0x7c00 | (abs > 0x7f800000 ? 0x0200 : 0);
+    }
+    if (abs >= 0x477ff000) {  // rounds past 65504
+      return sign | 0x7c00;
+    }
+    if (abs < 0x38800000) {  // subnormal or zero
+      // 0.5f has the same ulp as a half subnormal, so the FPU rounds for us
+      auto aligned = std::bit_cast<std::uint32_t>(
+          std::bit_cast<float>(abs) + 0.5f);
+      return sign | static_cast<std::uint16_t>(aligned - 0x3f000000);
+    }
+
+    std::uint32_t odd = (abs >> 13) & 1;
+    abs += 0xc8000fff + odd;  // rebias exponent by -112 and round
+    return sign | static_cast<std::uint16_t>(abs >> 13);
+  }
+
+  static constexpr float ToFloat(std::uint16_t half) {
+    std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000) << 16;
+    std::uint32_t exponent = (half >> 10) & 0x1f;
+    std::uint32_t mantissa = half & 0x03ff;
+
+    if (exponent == 0x1f) {
+      return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+    }
+    if (exponent == 0) {
+      float magnitude = static_cast<float>(mantissa) * 0x1p-24f;
+      return sign ? -magnitude : magnitude;
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) |
+                                (mantissa << 13));
+  }
+
+  std::uint16_t m_bits = 0;
+};
+
+// bfloat16 storage type: upper half of a float, same exponent range.
+// Like Float16, comparisons go through float.
+class BFloat16 {
+ public:
+  constexpr BFloat16() = default;
+  constexpr BFloat16(float value) : m_bits(FromFloat(value)) {}
+
+  static constexpr BFloat16 FromBits(std::uint16_t bits) {
+    BFloat16 result;
+    result.m_bits = bits;
+    return result;
+  }
+
+  constexpr operator float() const {
+    return std::bit_cast<float>(static_cast<std::uint32_t>(m_bits) << 16);
+  }
+
+  constexpr std::uint16_t bits() const { return m_bits; }
+
+ private:
+  static constexpr std::uint16_t FromFloat(float value) {
+    auto bits = std::bit_cast<std::uint32_t>(value);
+
+    if ((bits & 0x7fffffff) > 0x7f800000) {  // keep nan quiet
+      return static_cast<std::uint16_t>((bits >> 16) | 0x0040);
+    }
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return static_cast<std::uint16_t>(bits >> 16);
+  }
+
+  std::uint16_t m_bits = 0;
+};
+
+// Type wide enough to sum products of T without overflow or heavy rounding
+template <typename T>
+struct Accumulator {
+  using type = T;
+};
+
+template <>
+struct Accumulator<std::int8_t> {
+  using type = std::int32_t;
+};
+
+template <>
+struct Accumulator<std::uint8_t> {
+  using type = std::int32_t;
+};
+
+template <>
+struct Accumulator<std::int16_t> {
+  using type = std::int32_t;
+};
+
+template <>
+struct Accumulator<Float16> {
+  using type = float;
+};
+
+template <>
+struct Accumulator<BFloat16> {
+  using type = float;
+};
+
+template <typename T>
+using AccumulatorType = typename Accumulator<T>::type;
+
+// Like DotProduct2D, but sums in Acc and stores the result as Out
+template <typename Out, typename T, typename Acc = AccumulatorType<T>>
+Matrix2D<Out> MixedDotProduct2D(const Matrix2D<T>& lhs,
+                                const Matrix2D<T>& rhs) {
+  using SizeType = Matrix2D<T>::SizeType;
+  auto lhs_shape = lhs.shape();
+  auto rhs_shape = rhs.shape();
+
+  if (lhs_shape.cols != rhs_shape.rows) {
+    std::string message = std::format(
+        "ShapeMismatchException: MixedDotProduct2D(): {}x{} dot {}x{}",
+        lhs_shape.rows, lhs_shape.cols, rhs_shape.rows, rhs_shape.cols);
+    throw ShapeMismatchException(message);
+  }
+
+  auto result = Matrix2D<Out>(Shape2D{lhs_shape.rows, rhs_shape.cols});
+  auto& out = result.data();
+  const auto& a = lhs.data();
+  const auto& b = rhs.data();
+
+  SizeType n = lhs_shape.cols;
+  SizeType m = rhs_shape.cols;
+  std::vector<Acc> row_sum(m);
+
+  // i-k-j order keeps both rhs and the accumulator row contiguous
+  for (SizeType i = 0; i < lhs_shape.rows; i++) {
+    std::fill(row_sum.begin(), row_sum.end(), Acc{});
+
+    for (SizeType k = 0; k < n; k++) {
+      Acc a_ik = static_cast<Acc>(a[i * n + k]);
+      const T* b_row = b.data() + k * m;
+
+      for (SizeType j = 0; j < m; j++) {
+        row_sum[j] += a_ik * static_cast<Acc>(b_row[j]);
+      }
+    }
+
+    for (SizeType j = 0; j < m; j++) {
+      out[i * m + j] = static_cast<Out>(row_sum[j]);
+    }
+  }
+
+  return result;
+}
+
+// Which axis owns a separate scale and zero-point
+enum class QuantizationAxis { Rows, Cols };
+
+// Affine-quantized matrix: real = (q - zero_point) * scale
+template <typename T = std::int8_t>
+class QuantizedMatrix2D {
+ public:
+  using SizeType = int;
+
+ public:
+  QuantizedMatrix2D(Shape2D<SizeType> shape, QuantizationAxis axis)
+      : m_shape{shape},
+        m_axis{axis},
+        m_data(shape.rows * shape.cols),
+        m_scales(axis == QuantizationAxis::Rows ? shape.rows : shape.cols,
+                 1.0f),
+        m_zero_points(m_scales.size(), 0) {}
+
+  const T& get(SizeType row, SizeType col) const {
+    if (row < 0 or row >= m_shape.rows) throw std::out_of_range("Out of row");
+    if (col < 0 or col >= m_shape.cols) throw std::out_of_range("Out of col");
+
+    return m_data.at(row * m_shape.cols + col);
+  }
+
+  T& get(SizeType row, SizeType col) {
+    if (row < 0 or row >= m_shape.rows) throw std::out_of_range("Out of row");
+    if (col < 0 or col >= m_shape.cols) throw std::out_of_range("Out of col");
+
+    return m_data.at(row * m_shape.cols + col);
+  }
+
+  auto rows() const { return m_shape.rows; }
+  auto cols() const { return m_shape.cols; }
+  auto shape() const { return m_shape; }
+  auto axis() const { return m_axis; }
+
+  auto& data() { return m_data; }
+  const auto& data() const { return m_data; }
+
+  auto& scales() { return m_scales; }
+  const auto& scales() const { return m_scales; }
+
+  auto& zeroPoints() { return m_zero_points; }
+  const auto& zeroPoints() const { return m_zero_points; }
+
+ private:
+  Shape2D<SizeType> m_shape;
+  QuantizationAxis m_axis;
+  std::vector<T> m_data;
+  std::vector<float> m_scales;
+  std::vector<std::int32_t> m_zero_points;
+};
+
+namespace detail {
+
+// Branch-free round half away from zero, unlike std::lround it vectorizes
+inline std::int32_t RoundToInt(float value) {
+  return static_cast<std::int32_t>(value + (value < 0.0f ? -0.5f : 0.5f));
+}
+
+// inf would make the scale inf and NaN slips past std::min/std::max,
+// either way the float to int conversion below is undefined
+inline void RequireFinite(bool finite) {
+  if (!finite) throw std::invalid_argument("Quantize(): non-finite value");
+}
+
+template <typename Q>
+void ScaleAndZeroPoint(float min, float max, float& scale,
+                       std::int32_t& zero_point) {
+  constexpr float qmin = std::numeric_limits<Q>::min();
+  constexpr float qmax = std::numeric_limits<Q>::max();
+
+  // zero must stay exactly representable
+  min = std::min(min, 0.0f);
+  max = std::max(max, 0.0f);
+
+  scale = (max - min) / (qmax - qmin);
+  if (scale == 0.0f) scale = 1.0f;
+
+  zero_point = std::clamp(RoundToInt(qmin - min / scale),
+                          static_cast<std::int32_t>(qmin),
+                          static_cast<std::int32_t>(qmax));
+}
+
+}  // namespace detail
+
+template <typename Q = std::int8_t, typename T>
+QuantizedMatrix2D<Q> Quantize(const Matrix2D<T>& matrix,
+                              QuantizationAxis axis) {
+  using SizeType = QuantizedMatrix2D<Q>::SizeType;
+  constexpr std::int32_t qmin = std::numeric_limits<Q>::min();
+  constexpr std::int32_t qmax = std::numeric_limits<Q>::max();
+
+  auto result = QuantizedMatrix2D<Q>(matrix.shape(), axis);
+  SizeType rows = matrix.rows();
+  SizeType cols = matrix.cols();
+  const auto& in = matrix.data();
+  auto& out = result.data();
+  auto& scales = result.scales();
+  auto& zero_points = result.zeroPoints();
+
+  if (axis == QuantizationAxis::Rows) {
+    for (SizeType row = 0; row < rows; row++) {
+      const T* in_row = in.data() + row * cols;
+      Q* out_row = out.data() + row * cols;
+
+      float min = 0.0f;
+      float max = 0.0f;
+      bool finite = true;
+      for (SizeType col = 0; col < cols; col++) {
+        auto value = static_cast<float>(in_row[col]);
+        min = std::min(min, value);
+        max = std::max(max, value);
+        finite &= std::isfinite(value);
+      }
+      detail::RequireFinite(finite);
+      detail::ScaleAndZeroPoint<Q>(min, max, scales[row], zero_points[row]);
+
+      float inv_scale = 1.0f / scales[row];
+      std::int32_t zero_point = zero_points[row];
+      for (SizeType col = 0; col < cols; col++) {
+        auto q = detail::RoundToInt(static_cast<float>(in_row[col]) *
+                                    inv_scale) +
+                 zero_point;
+        out_row[col] = static_cast<Q>(std::clamp(q, qmin, qmax));
+      }
+    }
+  } else {
+    // Walk rows and keep per-column state in arrays so the
+    // inner loops stay contiguous
+    std::vector<float> min(cols, 0.0f);
+    std::vector<float> max(cols, 0.0f);
+    bool finite = true;
+    for (SizeType row = 0; row < rows; row++) {
+      const T* in_row = in.data() + row * cols;
+      for (SizeType col = 0; col < cols; col++) {
+        auto value = static_cast<float>(in_row[col]);
+        min[col] = std::min(min[col], value);
+        max[col] = std::max(max[col], value);
+        finite &= std::isfinite(value);
+      }
+    }
+    detail::RequireFinite(finite);
+
+    std::vector<float> inv_scale(cols);
+    for (SizeType col = 0; col < cols; col++) {
+      detail::ScaleAndZeroPoint<Q>(min[col], max[col], scales[col],
+                                   zero_points[col]);
+      inv_scale[col] = 1.0f / scales[col];
+    }
+
+    for (SizeType row = 0; row < rows; row++) {
+      const T* in_row = in.data() + row * cols;
+      Q* out_row = out.data() + row * cols;
+      for (SizeType col = 0; col < cols; col++) {
+        auto q = detail::RoundToInt(static_cast<float>(in_row[col]) *
+                                    inv_scale[col]) +
+                 zero_points[col];
+        out_row[col] = static_cast<Q>(std::clamp(q, qmin, qmax));
+      }
+    }
+  }
+
+  return result;
+}
+
+template <typename Out = float, typename Q>
+Matrix2D<Out> Dequantize(const QuantizedMatrix2D<Q>& matrix) {
+  using SizeType = QuantizedMatrix2D<Q>::SizeType;
+
+  auto result = Matrix2D<Out>(matrix.shape());
+  SizeType rows = matrix.rows();
+  SizeType cols = matrix.cols();
+  const auto& in = matrix.data();
+  auto& out = result.data();
+  const auto& scales = matrix.scales();
+  const auto& zero_points = matrix.zeroPoints();
+  bool per_row = matrix.axis() == QuantizationAxis::Rows;
+
+  for (SizeType row = 0; row < rows; row++) {
+    const Q* in_row = in.data() + row * cols;
+    Out* out_row = out.data() + row * cols;
+
+    if (per_row) {
+      float scale = scales[row];
+      std::int32_t zero_point = zero_points[row];
+      for (SizeType col = 0; col < cols; col++) {
+        out_row[col] = static_cast<Out>(
+            static_cast<float>(in_row[col] - zero_point) * scale);
+      }
+    } else {
+      for (SizeType col = 0; col < cols; col++) {
+        out_row[col] = static_cast<Out>(
+            static_cast<float>(in_row[col] - zero_points[col]) *
+            scales[col]);
+      }
+    }
+  }
+
+  return result;
+}
+
+// Integer GEMM on quantized operands. The scale has to be constant along
+// the reduced dimension, so lhs must be quantized per row and rhs per
+// column. Products are summed in int32 and rescaled once per element.
+template <typename Out = float, typename Q>
+Matrix2D<Out> QuantizedDotProduct2D(const QuantizedMatrix2D<Q>& lhs,
+                                    const QuantizedMatrix2D<Q>& rhs) {
+  using SizeType = QuantizedMatrix2D<Q>::SizeType;
+  auto lhs_shape = lhs.shape();
+  auto rhs_shape = rhs.shape();
+
+  if (lhs_shape.cols != rhs_shape.rows) {
+    std::string message = std::format(
+        "ShapeMismatchException: QuantizedDotProduct2D(): {}x{} dot {}x{}",
+        lhs_shape.rows, lhs_shape.cols, rhs_shape.rows, rhs_shape.cols);
+    throw ShapeMismatchException(message);
+  }
+  if (lhs.axis() != QuantizationAxis::Rows or
+      rhs.axis() != QuantizationAxis::Cols) {
+    throw std::invalid_argument(
+        "QuantizedDotProduct2D(): expected per-row lhs and per-col rhs");
+  }
+
+  SizeType n = lhs_shape.cols;
+  SizeType m = rhs_shape.cols;
+  const auto& a = lhs.data();
+  const auto& b = rhs.data();
+
+  // sum (a - za)(b - zb) = sum ab - zb sum a - za sum b + n za zb
+  std::vector<std::int32_t> b_col_sum(m, 0);
+  for (SizeType k = 0; k < n; k++) {
+    const Q* b_row = b.data() + k * m;
+    for (SizeType j = 0; j < m; j++) {
+      b_col_sum[j] += b_row[j];
+    }
+  }
+
+  auto result = Matrix2D<Out>(Shape2D{lhs_shape.rows, m});
+  auto& out = result.data();
+  std::vector<std::int32_t> row_sum(m);
+
+  for (SizeType i = 0; i < lhs_shape.rows; i++) {
+    std::fill(row_sum.begin(), row_sum.end(), 0);
+    std::int32_t a_row_sum = 0;
+
+    for (SizeType k = 0; k < n; k++) {
+      std::int32_t a_ik = a[i * n + k];
+      const Q* b_row = b.data() + k * m;
+      a_row_sum += a_ik;
+
+      for (SizeType j = 0; j < m; j++) {
+        row_sum[j] += a_ik * static_cast<std::int32_t>(b_row[j]);
+      }
+    }
+
+    std::int32_t za = lhs.zeroPoints()[i];
+    float sa = lhs.scales()[i];
+    for (SizeType j = 0; j < m; j++) {
+      std::int32_t zb = rhs.zeroPoints()[j];
+      std::int32_t acc =
+          row_sum[j] - zb * a_row_sum - za * b_col_sum[j] + n * za * zb;
+      out[i * m + j] =
+          static_cast<Out>(static_cast<float>(acc) * sa * rhs.scales()[j]);
+    }
+  }
+
+  return result;
+}
+
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
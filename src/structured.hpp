@@ -0,0 +1,760 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "matrix2d.hpp"
+#include "matrix2dview.hpp"
+
+namespace qustrolabe {
+namespace cpp_matrix {
+
+// Packed storage for structured square and banded matrices. Each class
+// converts from a Matrix2D (reading only the part it stores), back with
+// ToMatrix2D(), and exposes get(row, col) over the full logical shape.
+// Structural zeros read as T{} and cannot be written.
+//
+// SymmetricView, TriangularView and BandedView give the same structure to
+// dense storage that already exists, without packing it. They go through
+// the same DotProduct2D kernels.
+
+namespace detail {
+
+template <typename Matrix>
+void RequireSquare(const Matrix& matrix, const char* caller) {
+  if (matrix.rows() != matrix.cols()) {
+    std::string message =
+        std::format("ShapeMismatchException: {}: {}x{} is not square",
+                    caller, matrix.rows(), matrix.cols());
+    throw ShapeMismatchException(message);
+  }
+}
+
+template <typename Lhs, typename Rhs>
+void RequireDotShape(const Lhs& lhs, const Rhs& rhs) {
+  if (lhs.cols() != rhs.rows()) {
+    std::string message =
+        std::format("ShapeMismatchException: {}x{} dot {}x{}", lhs.rows(),
+                    lhs.cols(), rhs.rows(), rhs.cols());
+    throw ShapeMismatchException(message);
+  }
+}
+
+// The same strided data read with rows and cols swapped
+template <typename T>
+Matrix2DView<T> TransposedView(Matrix2DView<T> view) {
+  return Matrix2DView<T>(view.data(), Shape2D{view.cols(), view.rows()},
+                         view.colStride(), view.rowStride());
+}
+
+}  // namespace detail
+
+// Symmetric matrix storing only its lower triangle, packed by rows:
+// n(n+1)/2 elements
+template <typename T>
+class SymmetricMatrix {
+ public:
+  using SizeType = int;
+
+ public:
+  explicit SymmetricMatrix(SizeType n, T init_value = {})
+      : m_size{n}, m_data(PackedSize(n), init_value) {}
+
+  // Reads the lower triangle, the upper one is assumed to mirror it
+  template <typename Layout>
+  explicit SymmetricMatrix(const Matrix2D<T, Layout>& dense)
+      : SymmetricMatrix(dense.rows()) {
+    detail::RequireSquare(dense, "SymmetricMatrix()");
+
+    for (SizeType row = 0; row < m_size; row++) {
+      for (SizeType col = 0; col <= row; col++) {
+        m_data[Index(row, col)] = dense.get(row, col);
+      }
+    }
+  }
+
+  // (row, col) and (col, row) are the same element
+  const T& get(SizeType row, SizeType col) const {
+    CheckBounds(row, col);
+    return m_data[row >= col ? Index(row, col) : Index(col, row)];
+  }
+
+  T& get(SizeType row, SizeType col) {
+    CheckBounds(row, col);
+    return m_data[row >= col ? Index(row, col) : Index(col, row)];
+  }
+
+  bool operator==(const SymmetricMatrix& other) const = default;
+
+  auto rows() const { return m_size; }
+  auto cols() const { return m_size; }
+  auto shape() const { return Shape2D{m_size, m_size}; }
+
+  auto& data() { return m_data; }
+  const auto& data() const { return m_data; }
+
+  // Unchecked read of (row, col), row >= col, for the kernels
+  const T& element(SizeType row, SizeType col) const {
+    return m_data[Index(row, col)];
+  }
+
+  // Position of (row, col), row >= col, in the packed buffer
+  static constexpr std::size_t Index(SizeType row, SizeType col) {
+    return static_cast<std::size_t>(row) * (row + 1) / 2 + col;
+  }
+
+  static constexpr std::size_t PackedSize(SizeType n) {
+    return static_cast<std::size_t>(n) * (n + 1) / 2;
+  }
+
+ private:
+  void CheckBounds(SizeType row, SizeType col) const {
+    if (row < 0 or row >= m_size) throw std::out_of_range("Out of row");
+    if (col < 0 or col >= m_size) throw std::out_of_range("Out of col");
+  }
+
+  SizeType m_size;
+  std::vector<T> m_data;
+};
+
+enum class Triangle { Lower, Upper };
+
+// Triangular matrix storing n(n+1)/2 elements. Lower is packed by rows
+// and Upper by columns, so the transpose of one is the other with the
+// very same buffer.
+template <typename T, Triangle Part = Triangle::Lower>
+class TriangularMatrix {
+ public:
+  using SizeType = int;
+
+ public:
+  explicit TriangularMatrix(SizeType n, T init_value = {})
+      : m_size{n}, m_data(SymmetricMatrix<T>::PackedSize(n), init_value) {}
+
+  // Reads the stored triangle, the rest of dense is ignored
+  template <typename Layout>
+  explicit TriangularMatrix(const Matrix2D<T, Layout>& dense)
+      : TriangularMatrix(dense.rows()) {
+    detail::RequireSquare(dense, "TriangularMatrix()");
+
+    for (SizeType row = 0; row < m_size; row++) {
+      for (SizeType col = 0; col < m_size; col++) {
+        if (Stored(row, col)) m_data[Index(row, col)] = dense.get(row, col);
+      }
+    }
+  }
+
+  TriangularMatrix(SizeType n, std::vector<T> packed)
+      : m_size{n}, m_data(std::move(packed)) {
+    if (m_data.size() != SymmetricMatrix<T>::PackedSize(n)) {
+      throw std::invalid_argument("TriangularMatrix(): wrong packed size");
+    }
+  }
+
+  T get(SizeType row, SizeType col) const {
+    CheckBounds(row, col);
+    return Stored(row, col) ? m_data[Index(row, col)] : T{};
+  }
+
+  T& get(SizeType row, SizeType col) {
+    CheckBounds(row, col);
+    if (!Stored(row, col)) throw std::out_of_range("Outside of triangle");
+    return m_data[Index(row, col)];
+  }
+
+  bool operator==(const TriangularMatrix& other) const = default;
+
+  auto rows() const { return m_size; }
+  auto cols() const { return m_size; }
+  auto shape() const { return Shape2D{m_size, m_size}; }
+
+  auto& data() { return m_data; }
+  const auto& data() const { return m_data; }
+
+  // Unchecked read of a stored (row, col), for the kernels
+  const T& element(SizeType row, SizeType col) const {
+    return m_data[Index(row, col)];
+  }
+
+  static constexpr bool Stored(SizeType row, SizeType col) {
+    return Part == Triangle::Lower ? row >= col : row <= col;
+  }
+
+  // Position of a stored (row, col) in the packed buffer
+  static constexpr std::size_t Index(SizeType row, SizeType col) {
+    if constexpr (Part == Triangle::Lower) {
+      return SymmetricMatrix<T>::Index(row, col);
+    } else {
+      return SymmetricMatrix<T>::Index(col, row);
+    }
+  }
+
+ private:
+  void CheckBounds(SizeType row, SizeType col) const {
+    if (row < 0 or row >= m_size) throw std::out_of_range("Out of row");
+    if (col < 0 or col >= m_size) throw std::out_of_range("Out of col");
+  }
+
+  SizeType m_size;
+  std::vector<T> m_data;
+};
+
+// Band matrix with `lower` sub-diagonals and `upper` super-diagonals.
+// Each row keeps lower + upper + 1 slots, slot (col - row + lower).
+template <typename T>
+class BandedMatrix {
+ public:
+  using SizeType = int;
+
+ public:
+  BandedMatrix(Shape2D<SizeType> shape, SizeType lower, SizeType upper,
+               T init_value = {})
+      : m_shape{shape},
+        m_lower{lower},
+        m_upper{upper},
+        m_data(static_cast<std::size_t>(shape.rows) * Slots(lower, upper),
+               init_value) {}
+
+  // Copies the band of dense, everything outside it is ignored
+  template <typename Layout>
+  BandedMatrix(const Matrix2D<T, Layout>& dense, SizeType lower,
+               SizeType upper)
+      : BandedMatrix(dense.shape(), lower, upper) {
+    for (SizeType row = 0; row < m_shape.rows; row++) {
+      for (SizeType col = FirstCol(row); col < EndCol(row); col++) {
+        m_data[Index(row, col)] = dense.get(row, col);
+      }
+    }
+  }
+
+  T get(SizeType row, SizeType col) const {
+    CheckBounds(row, col);
+    return Stored(row, col) ? m_data[Index(row, col)] : T{};
+  }
+
+  T& get(SizeType row, SizeType col) {
+    CheckBounds(row, col);
+    if (!Stored(row, col)) throw std::out_of_range("Outside of band");
+    return m_data[Index(row, col)];
+  }
+
+  bool operator==(const BandedMatrix& other) const = default;
+
+  auto rows() const { return m_shape.rows; }
+  auto cols() const { return m_shape.cols; }
+  auto shape() const { return m_shape; }
+  auto lower() const { return m_lower; }
+  auto upper() const { return m_upper; }
+
+  auto& data() { return m_data; }
+  const auto& data() const { return m_data; }
+
+  // The packed storage as a rows x (lower + upper + 1) matrix, one
+  // diagonal per column
+  Matrix2DView<T> band() {
+    return Matrix2DView<T>(m_data.data(), BandShape(), m_lower + m_upper + 1,
+                           1);
+  }
+
+  Matrix2DView<const T> band() const {
+    return Matrix2DView<const T>(m_data.data(), BandShape(),
+                                 m_lower + m_upper + 1, 1);
+  }
+
+  // Unchecked read of an in-band (row, col), for the kernels
+  const T& element(SizeType row, SizeType col) const {
+    return m_data[Index(row, col)];
+  }
+
+  // Columns [FirstCol, EndCol) of a row lie inside the band
+  SizeType FirstCol(SizeType row) const { return std::max(0, row - m_lower); }
+  SizeType EndCol(SizeType row) const {
+    return std::min(m_shape.cols, row + m_upper + 1);
+  }
+
+  bool Stored(SizeType row, SizeType col) const {
+    return col >= row - m_lower and col <= row + m_upper;
+  }
+
+  std::size_t Index(SizeType row, SizeType col) const {
+    return static_cast<std::size_t>(row) * (m_lower + m_upper + 1) +
+           (col - row + m_lower);
+  }
+
+ private:
+  // Slots per row, checked before the storage is allocated
+  static SizeType Slots(SizeType lower, SizeType upper) {
+    if (lower < 0 or upper < 0) {
+      throw std::invalid_argument("BandedMatrix(): negative bandwidth");
+    }
+    return lower + upper + 1;
+  }
+
+  Shape2D<SizeType> BandShape() const {
+    return Shape2D{m_shape.rows, m_lower + m_upper + 1};
+  }
+
+  void CheckBounds(SizeType row, SizeType col) const {
+    if (row < 0 or row >= m_shape.rows) throw std::out_of_range("Out of row");
+    if (col < 0 or col >= m_shape.cols) throw std::out_of_range("Out of col");
+  }
+
+  Shape2D<SizeType> m_shape;
+  SizeType m_lower;
+  SizeType m_upper;
+  std::vector<T> m_data;
+};
+
+// Views over dense storage. Each one wraps a Matrix2DView, so a Matrix2D of
+// either layout, a raw strided buffer or an mdspan all work. Only the part
+// the structure stores is ever read. Use const T for a read-only view.
+
+// Reads the lower triangle of a square view, the upper one mirrors it
+template <typename T>
+class SymmetricView {
+ public:
+  using SizeType = int;
+  using ValueType = std::remove_const_t<T>;
+
+ public:
+  explicit SymmetricView(Matrix2DView<T> dense) : m_dense{dense} {
+    detail::RequireSquare(dense, "SymmetricView()");
+  }
+
+  // (row, col) and (col, row) are the same element
+  T& get(SizeType row, SizeType col) const {
+    return row >= col ? m_dense.get(row, col) : m_dense.get(col, row);
+  }
+
+  // Unchecked read of (row, col), row >= col, for the kernels
+  T& element(SizeType row, SizeType col) const {
+    return m_dense.data()[row * m_dense.rowStride() +
+                          col * m_dense.colStride()];
+  }
+
+  auto rows() const { return m_dense.rows(); }
+  auto cols() const { return m_dense.cols(); }
+  auto shape() const { return m_dense.shape(); }
+  auto dense() const { return m_dense; }
+
+ private:
+  Matrix2DView<T> m_dense;
+};
+
+template <typename T, typename Layout>
+SymmetricView(Matrix2D<T, Layout>&) -> SymmetricView<T>;
+
+template <typename T, typename Layout>
+SymmetricView(const Matrix2D<T, Layout>&) -> SymmetricView<const T>;
+
+// Reads one triangle of a square view, the other one reads as T{}
+template <typename T, Triangle Part = Triangle::Lower>
+class TriangularView {
+ public:
+  using SizeType = int;
+  using ValueType = std::remove_const_t<T>;
+
+ public:
+  explicit TriangularView(Matrix2DView<T> dense) : m_dense{dense} {
+    detail::RequireSquare(dense, "TriangularView()");
+  }
+
+  ValueType get(SizeType row, SizeType col) const {
+    auto value = m_dense.get(row, col);
+    return Stored(row, col) ? value : ValueType{};
+  }
+
+  // Unchecked read of a stored (row, col), for the kernels
+  T& element(SizeType row, SizeType col) const {
+    return m_dense.data()[row * m_dense.rowStride() +
+                          col * m_dense.colStride()];
+  }
+
+  auto rows() const { return m_dense.rows(); }
+  auto cols() const { return m_dense.cols(); }
+  auto shape() const { return m_dense.shape(); }
+  auto dense() const { return m_dense; }
+
+  static constexpr bool Stored(SizeType row, SizeType col) {
+    return TriangularMatrix<ValueType, Part>::Stored(row, col);
+  }
+
+ private:
+  Matrix2DView<T> m_dense;
+};
+
+template <typename T, typename Layout>
+TriangularView(Matrix2D<T, Layout>&) -> TriangularView<T>;
+
+template <typename T, typename Layout>
+TriangularView(const Matrix2D<T, Layout>&) -> TriangularView<const T>;
+
+// Reads the band of a view, everything outside it reads as T{}
+template <typename T>
+class BandedView {
+ public:
+  using SizeType = int;
+  using ValueType = std::remove_const_t<T>;
+
+ public:
+  BandedView(Matrix2DView<T> dense, SizeType lower, SizeType upper)
+      : m_dense{dense}, m_lower{lower}, m_upper{upper} {
+    if (lower < 0 or upper < 0) {
+      throw std::invalid_argument("BandedView(): negative bandwidth");
+    }
+  }
+
+  ValueType get(SizeType row, SizeType col) const {
+    auto value = m_dense.get(row, col);
+    return Stored(row, col) ? value : ValueType{};
+  }
+
+  // Unchecked read of an in-band (row, col), for the kernels
+  T& element(SizeType row, SizeType col) const {
+    return m_dense.data()[row * m_dense.rowStride() +
+                          col * m_dense.colStride()];
+  }
+
+  auto rows() const { return m_dense.rows(); }
+  auto cols() const { return m_dense.cols(); }
+  auto shape() const { return m_dense.shape(); }
+  auto dense() const { return m_dense; }
+  auto lower() const { return m_lower; }
+  auto upper() const { return m_upper; }
+
+  // Columns [FirstCol, EndCol) of a row lie inside the band
+  SizeType FirstCol(SizeType row) const { return std::max(0, row - m_lower); }
+  SizeType EndCol(SizeType row) const {
+    return std::min(cols(), row + m_upper + 1);
+  }
+
+  bool Stored(SizeType row, SizeType col) const {
+    return col >= row - m_lower and col <= row + m_upper;
+  }
+
+ private:
+  Matrix2DView<T> m_dense;
+  SizeType m_lower;
+  SizeType m_upper;
+};
+
+template <typename T, typename Layout>
+BandedView(Matrix2D<T, Layout>&, int, int) -> BandedView<T>;
+
+template <typename T, typename Layout>
+BandedView(const Matrix2D<T, Layout>&, int, int) -> BandedView<const T>;
+
+namespace detail {
+
+// Shared by the packed classes and the views. Structured only needs
+// rows(), cols(), element() on stored positions and, for a band,
+// FirstCol(), EndCol(), lower() and upper().
+
+template <typename Structured>
+using StructuredValue = std::remove_cvref_t<
+    decltype(std::declval<const Structured&>().element(0, 0))>;
+
+template <typename Layout, typename Structured>
+auto SymmetricToMatrix2D(const Structured& matrix) {
+  using SizeType = Structured::SizeType;
+  auto result = Matrix2D<StructuredValue<Structured>, Layout>(matrix.shape());
+
+  for (SizeType row = 0; row < matrix.rows(); row++) {
+    for (SizeType col = 0; col <= row; col++) {
+      const auto& value = matrix.element(row, col);
+      result.get(row, col) = value;
+      result.get(col, row) = value;
+    }
+  }
+
+  return result;
+}
+
+template <typename Layout, typename Structured>
+auto TriangularToMatrix2D(const Structured& matrix) {
+  using SizeType = Structured::SizeType;
+  auto result = Matrix2D<StructuredValue<Structured>, Layout>(matrix.shape());
+
+  for (SizeType row = 0; row < matrix.rows(); row++) {
+    for (SizeType col = 0; col < matrix.cols(); col++) {
+      if (matrix.Stored(row, col)) {
+        result.get(row, col) = matrix.element(row, col);
+      }
+    }
+  }
+
+  return result;
+}
+
+template <typename Layout, typename Structured>
+auto BandedToMatrix2D(const Structured& matrix) {
+  using SizeType = Structured::SizeType;
+  auto result = Matrix2D<StructuredValue<Structured>, Layout>(matrix.shape());
+
+  for (SizeType row = 0; row < matrix.rows(); row++) {
+    for (SizeType col = matrix.FirstCol(row); col < matrix.EndCol(row);
+         col++) {
+      result.get(row, col) = matrix.element(row, col);
+    }
+  }
+
+  return result;
+}
+
+// Each kernel walks only the stored elements and streams rows of rhs and
+// of the result.
+
+// SYMM: every off-diagonal element is read once and used for both
+// (row, col) and (col, row)
+template <typename Structured, typename T, typename Layout>
+Matrix2D<T, Layout> SymmetricDotProduct2D(const Structured& lhs,
+                                          const Matrix2D<T, Layout>& rhs) {
+  using SizeType = Structured::SizeType;
+  RequireDotShape(lhs, rhs);
+
+  SizeType n = lhs.rows();
+  SizeType m = rhs.cols();
+  CPP_MATRIX_PROFILE_OP(DotProduct2D, std::uint64_t(n) * m,
+                        std::uint64_t(2) * n * n * m,
+                        std::uint64_t(n) * m * sizeof(T));
+
+  auto result = Matrix2D<T, Layout>(Shape2D{n, m});
+  const auto& b = rhs.data();
+  auto& c = result.data();
+
+  auto shape = Shape2D{n, m};
+
+  for (SizeType i = 0; i < n; i++) {
+    for (SizeType k = 0; k < i; k++) {
+      T a_ik = lhs.element(i, k);
+
+      for (SizeType j = 0; j < m; j++) {
+        c[Layout::Offset(shape, i, j)] += a_ik * b[Layout::Offset(shape, k, j)];
+        c[Layout::Offset(shape, k, j)] += a_ik * b[Layout::Offset(shape, i, j)];
+      }
+    }
+
+    T a_ii = lhs.element(i, i);
+    for (SizeType j = 0; j < m; j++) {
+      c[Layout::Offset(shape, i, j)] += a_ii * b[Layout::Offset(shape, i, j)];
+    }
+  }
+
+  return result;
+}
+
+// TRMM: n(n+1)m multiply-adds instead of 2n^2m
+template <Triangle Part, typename Structured, typename T, typename Layout>
+Matrix2D<T, Layout> TriangularDotProduct2D(const Structured& lhs,
+                                           const Matrix2D<T, Layout>& rhs) {
+  using SizeType = Structured::SizeType;
+  RequireDotShape(lhs, rhs);
+
+  SizeType n = lhs.rows();
+  SizeType m = rhs.cols();
+  CPP_MATRIX_PROFILE_OP(DotProduct2D, std::uint64_t(n) * m,
+                        std::uint64_t(n) * (n + 1) * m,
+                        std::uint64_t(n) * m * sizeof(T));
+
+  auto result = Matrix2D<T, Layout>(Shape2D{n, m});
+  const auto& b = rhs.data();
+  auto& c = result.data();
+  auto shape = Shape2D{n, m};
+
+  for (SizeType i = 0; i < n; i++) {
+    SizeType k_begin = Part == Triangle::Lower ? 0 : i;
+    SizeType k_end = Part == Triangle::Lower ? i + 1 : n;
+
+    for (SizeType k = k_begin; k < k_end; k++) {
+      T a_ik = lhs.element(i, k);
+
+      for (SizeType j = 0; j < m; j++) {
+        c[Layout::Offset(shape, i, j)] += a_ik * b[Layout::Offset(shape, k, j)];
+      }
+    }
+  }
+
+  return result;
+}
+
+// Banded product, rhs is usually a single column (mat-vec):
+// rows * (lower + upper + 1) * cols multiply-adds at most
+template <typename Structured, typename T, typename Layout>
+Matrix2D<T, Layout> BandedDotProduct2D(const Structured& lhs,
+                                       const Matrix2D<T, Layout>& rhs) {
+  using SizeType = Structured::SizeType;
+  RequireDotShape(lhs, rhs);
+
+  SizeType n = lhs.rows();
+  SizeType m = rhs.cols();
+  CPP_MATRIX_PROFILE_OP(
+      DotProduct2D, std::uint64_t(n) * m,
+      std::uint64_t(2) * n * (lhs.lower() + lhs.upper() + 1) * m,
+      std::uint64_t(n) * m * sizeof(T));
+
+  auto result = Matrix2D<T, Layout>(Shape2D{n, m});
+  const auto& b = rhs.data();
+  auto& c = result.data();
+  auto rhs_shape = rhs.shape();
+  auto result_shape = result.shape();
+
+  for (SizeType i = 0; i < n; i++) {
+    for (SizeType k = lhs.FirstCol(i); k < lhs.EndCol(i); k++) {
+      T a_ik = lhs.element(i, k);
+
+      for (SizeType j = 0; j < m; j++) {
+        c[Layout::Offset(result_shape, i, j)] +=
+            a_ik * b[Layout::Offset(rhs_shape, k, j)];
+      }
+    }
+  }
+
+  return result;
+}
+
+}  // namespace detail
+
+// Dense copies
+
+template <typename Layout = RowMajor, typename T>
+Matrix2D<T, Layout> ToMatrix2D(const SymmetricMatrix<T>& matrix) {
+  return detail::SymmetricToMatrix2D<Layout>(matrix);
+}
+
+template <typename Layout = RowMajor, typename T>
+Matrix2D<std::remove_const_t<T>, Layout> ToMatrix2D(SymmetricView<T> view) {
+  return detail::SymmetricToMatrix2D<Layout>(view);
+}
+
+template <typename Layout = RowMajor, typename T, Triangle Part>
+Matrix2D<T, Layout> ToMatrix2D(const TriangularMatrix<T, Part>& matrix) {
+  return detail::TriangularToMatrix2D<Layout>(matrix);
+}
+
+template <typename Layout = RowMajor, typename T, Triangle Part>
+Matrix2D<std::remove_const_t<T>, Layout> ToMatrix2D(
+    TriangularView<T, Part> view) {
+  return detail::TriangularToMatrix2D<Layout>(view);
+}
+
+template <typename Layout = RowMajor, typename T>
+Matrix2D<T, Layout> ToMatrix2D(const BandedMatrix<T>& matrix) {
+  return detail::BandedToMatrix2D<Layout>(matrix);
+}
+
+template <typename Layout = RowMajor, typename T>
+Matrix2D<std::remove_const_t<T>, Layout> ToMatrix2D(BandedView<T> view) {
+  return detail::BandedToMatrix2D<Layout>(view);
+}
+
+// Transposes
+
+// A symmetric matrix is its own transpose. A temporary is moved into the
+// result rather than returned by reference, so it cannot dangle.
+template <typename T>
+const SymmetricMatrix<T>& Transpose(const SymmetricMatrix<T>& matrix) {
+  return matrix;
+}
+
+template <typename T>
+SymmetricMatrix<T> Transpose(SymmetricMatrix<T>&& matrix) {
+  return std::move(matrix);
+}
+
+template <typename T>
+SymmetricView<T> Transpose(SymmetricView<T> view) {
+  return view;
+}
+
+// Lower by rows and Upper by columns share a packing, only the tag flips
+template <typename T, Triangle Part>
+auto Transpose(TriangularMatrix<T, Part> matrix) {
+  constexpr auto flipped =
+      Part == Triangle::Lower ? Triangle::Upper : Triangle::Lower;
+  auto n = matrix.rows();
+
+  return TriangularMatrix<T, flipped>(n, std::move(matrix.data()));
+}
+
+// Views transpose by swapping strides, nothing is copied
+template <typename T, Triangle Part>
+auto Transpose(TriangularView<T, Part> view) {
+  constexpr auto flipped =
+      Part == Triangle::Lower ? Triangle::Upper : Triangle::Lower;
+
+  return TriangularView<T, flipped>(detail::TransposedView(view.dense()));
+}
+
+template <typename T>
+BandedMatrix<T> Transpose(const BandedMatrix<T>& matrix) {
+  using SizeType = BandedMatrix<T>::SizeType;
+  auto shape = matrix.shape();
+  CPP_MATRIX_PROFILE_OP(Transpose, matrix.data().size(), 0,
+                        matrix.data().size() * sizeof(T));
+
+  auto result = BandedMatrix<T>(Shape2D{shape.cols, shape.rows},
+                                matrix.upper(), matrix.lower());
+
+  for (SizeType row = 0; row < shape.rows; row++) {
+    for (SizeType col = matrix.FirstCol(row); col < matrix.EndCol(row);
+         col++) {
+      result.data()[result.Index(col, row)] =
+          matrix.data()[matrix.Index(row, col)];
+    }
+  }
+
+  return result;
+}
+
+template <typename T>
+BandedView<T> Transpose(BandedView<T> view) {
+  return BandedView<T>(detail::TransposedView(view.dense()), view.upper(),
+                       view.lower());
+}
+
+// Products with a dense rhs, packed or view lhs alike
+
+template <typename T, typename Layout>
+Matrix2D<T, Layout> DotProduct2D(const SymmetricMatrix<T>& lhs,
+                                 const Matrix2D<T, Layout>& rhs) {
+  return detail::SymmetricDotProduct2D(lhs, rhs);
+}
+
+template <typename T, typename Layout>
+Matrix2D<std::remove_const_t<T>, Layout> DotProduct2D(
+    SymmetricView<T> lhs, const Matrix2D<std::remove_const_t<T>, Layout>& rhs) {
+  return detail::SymmetricDotProduct2D(lhs, rhs);
+}
+
+template <typename T, Triangle Part, typename Layout>
+Matrix2D<T, Layout> DotProduct2D(const TriangularMatrix<T, Part>& lhs,
+                                 const Matrix2D<T, Layout>& rhs) {
+  return detail::TriangularDotProduct2D<Part>(lhs, rhs);
+}
+
+template <typename T, Triangle Part, typename Layout>
+Matrix2D<std::remove_const_t<T>, Layout> DotProduct2D(
+    TriangularView<T, Part> lhs,
+    const Matrix2D<std::remove_const_t<T>, Layout>& rhs) {
+  return detail::TriangularDotProduct2D<Part>(lhs, rhs);
+}
+
+template <typename T, typename Layout>
+Matrix2D<T, Layout> DotProduct2D(const BandedMatrix<T>& lhs,
+                                 const Matrix2D<T, Layout>& rhs) {
+  return detail::BandedDotProduct2D(lhs, rhs);
+}
+
+template <typename T, typename Layout>
+Matrix2D<std::remove_const_t<T>, Layout> DotProduct2D(
+    BandedView<T> lhs, const Matrix2D<std::remove_const_t<T>, Layout>& rhs) {
+  return detail::BandedDotProduct2D(lhs, rhs);
+}
+
+}  // namespace cpp_matrix
+}  // namespace qustrolabe
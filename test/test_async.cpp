@@ -0,0 +1,290 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+namespace {
+
+using cpp_matrix::Matrix2D;
+
+// Minimal eagerly started coroutine, enough to drive co_await
+struct Task {
+  struct promise_type {
+    Task get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Takes everything by reference from the caller's frame, which outlives
+// the wait on done
+Task AwaitInto(const cpp_matrix::async::Future<int>& future,
+               Matrix2D<int>& result, std::promise<void>& done) {
+  result = co_await future;
+  done.set_value();
+}
+
+// Element that counts live instances and whose addition throws on
+// negative operands
+struct Element {
+  inline static std::atomic<long> live = 0;
+  inline static std::atomic<long> peak = 0;
+
+  int value = 0;
+
+  Element(int v = 0) : value{v} { Track(1); }
+  Element(const Element& other) : value{other.value} { Track(1); }
+  Element& operator=(const Element&) = default;
+  ~Element() { Track(-1); }
+
+  bool operator==(const Element& other) const { return value == other.value; }
+
+  friend Element operator+(const Element& lhs, const Element& rhs) {
+    if (lhs.value < 0 or rhs.value < 0) throw std::domain_error("negative");
+    return lhs.value + rhs.value;
+  }
+  friend Element operator-(const Element& lhs, const Element& rhs) {
+    return lhs.value - rhs.value;
+  }
+  friend Element operator*(const Element& lhs, const Element& rhs) {
+    return lhs.value * rhs.value;
+  }
+  Element& operator+=(const Element& other) { return *this = *this + other; }
+
+  static void Track(long delta) {
+    long now = live += delta;
+    long high = peak;
+    while (now > high and !peak.compare_exchange_weak(high, now)) {
+    }
+  }
+};
+
+// Element whose multiplication is slow and counts the ones in flight
+struct SlowElement {
+  inline static std::atomic<int> active = 0;
+
+  int value = 0;
+
+  SlowElement(int v = 0) : value{v} {}
+
+  bool operator==(const SlowElement& other) const = default;
+
+  friend SlowElement operator+(const SlowElement& lhs,
+                               const SlowElement& rhs) {
+    return lhs.value + rhs.value;
+  }
+  friend SlowElement operator-(const SlowElement& lhs,
+                               const SlowElement& rhs) {
+    if (lhs.value < 0 or rhs.value < 0) throw std::domain_error("negative");
+    return lhs.value - rhs.value;
+  }
+  friend SlowElement operator*(const SlowElement& lhs,
+                               const SlowElement& rhs) {
+    active++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    active--;
+    return lhs.value * rhs.value;
+  }
+  SlowElement& operator+=(const SlowElement& other) {
+    return *this = *this + other;
+  }
+};
+
+}  // namespace
+
+TEST_CASE("async DotProduct2D feeding Add", "[async]") {
+  namespace async = cpp_matrix::async;
+  using cpp_matrix::Rand2D;
+
+  auto a = Rand2D<int>({37, 21});
+  auto b = Rand2D<int>({21, 15});
+  auto c = Rand2D<int>({37, 15});
+  auto expected = cpp_matrix::Add(cpp_matrix::DotProduct2D(a, b), c);
+
+  auto pool = async::ThreadPool(4);
+  auto expr = async::Add(async::DotProduct2D(a, b), c);
+  REQUIRE(expr.shape() == expected.shape());
+
+  // Band sizes that do and don't divide the row count
+  for (int band_rows : {1, 4, 37, 64}) {
+    auto future = async::Launch(pool, expr, {band_rows});
+    REQUIRE(future.get() == expected);
+    REQUIRE(future.ready());
+  }
+}
+
+TEST_CASE("async builders check shapes", "[async]") {
+  namespace async = cpp_matrix::async;
+  using cpp_matrix::ShapeMismatchException;
+
+  auto a = Matrix2D<int>({2, 3});
+  auto b = Matrix2D<int>({3, 2});
+
+  REQUIRE_THROWS_AS(async::Add(a, b), ShapeMismatchException);
+  REQUIRE_THROWS_AS(async::Sub(a, b), ShapeMismatchException);
+  REQUIRE_THROWS_AS(async::DotProduct2D(a, a), ShapeMismatchException);
+  REQUIRE_THROWS_AS(async::Add(async::Transpose(a), a),
+                    ShapeMismatchException);
+  REQUIRE(async::DotProduct2D(a, b).shape() == cpp_matrix::Shape2D{2, 2});
+}
+
+TEST_CASE("async shared subexpressions and every op", "[async]") {
+  namespace async = cpp_matrix::async;
+  using cpp_matrix::Rand2D;
+
+  auto a = Rand2D<int>({12, 12});
+  auto b = Rand2D<int>({12, 12});
+
+  // ab is used three times but computed once per launch
+  auto ab = async::DotProduct2D(a, b);
+  auto expr = async::Sub(
+      async::DotProduct2D(ab, async::Transpose(ab)),
+      async::MultScalar(async::AddScalar(ab, 2), 3));
+
+  auto sync_ab = cpp_matrix::DotProduct2D(a, b);
+  auto expected = cpp_matrix::Sub(
+      cpp_matrix::DotProduct2D(sync_ab, cpp_matrix::Transpose(sync_ab)),
+      cpp_matrix::MultScalar(cpp_matrix::AddScalar(sync_ab, 2), 3));
+
+  auto pool = async::ThreadPool(3);
+  auto first = async::Launch(pool, expr, {5});
+  auto second = async::Launch(pool, expr, {2});
+  REQUIRE(first.get() == expected);
+  REQUIRE(second.get() == expected);
+
+  // Rvalue sources are owned by the expression
+  auto c = Rand2D<int>({3, 7});
+  auto owned = async::Transpose(Matrix2D<int>(c));
+  REQUIRE(async::Launch(pool, owned).get() == cpp_matrix::Transpose(c));
+
+  // A bare source completes right away
+  REQUIRE(async::Launch(pool, async::Expr<int>(a)).get() == a);
+}
+
+TEST_CASE("async independent launches share a pool", "[async]") {
+  namespace async = cpp_matrix::async;
+  using cpp_matrix::Rand2D;
+
+  auto pool = async::ThreadPool(4);
+  std::vector<Matrix2D<int>> inputs{};
+  for (int i = 0; i < 8; i++) {
+    inputs.push_back(Rand2D<int>({20, 20}));
+  }
+
+  std::vector<async::Future<int>> futures{};
+  for (const auto& input : inputs) {
+    futures.push_back(
+        async::Launch(pool, async::DotProduct2D(input, input), {3}));
+  }
+
+  for (std::size_t i = 0; i < inputs.size(); i++) {
+    REQUIRE(futures[i].get() ==
+            cpp_matrix::DotProduct2D(inputs[i], inputs[i]));
+  }
+}
+
+TEST_CASE("async Future is awaitable", "[async]") {
+  namespace async = cpp_matrix::async;
+  using cpp_matrix::Rand2D;
+
+  auto a = Rand2D<int>({16, 16});
+  auto expected = cpp_matrix::AddScalar(cpp_matrix::DotProduct2D(a, a), 1);
+
+  auto pool = async::ThreadPool(2);
+  auto future =
+      async::Launch(pool, async::AddScalar(async::DotProduct2D(a, a), 1), {4});
+
+  // The coroutine may resume on a pool thread, done signals when it ends
+  auto awaited = Matrix2D<int>({0, 0});
+  std::promise<void> done;
+  AwaitInto(future, awaited, done);
+  done.get_future().wait();
+  REQUIRE(awaited == expected);
+
+  // Awaiting a finished future doesn't suspend
+  auto again = Matrix2D<int>({0, 0});
+  std::promise<void> done_again;
+  AwaitInto(future, again, done_again);
+  REQUIRE(done_again.get_future().wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready);
+  REQUIRE(again == expected);
+}
+
+TEST_CASE("async exceptions reach the Future", "[async]") {
+  namespace async = cpp_matrix::async;
+
+  auto a = Matrix2D<Element>({8, 4}, Element(1));
+  auto b = Matrix2D<Element>({8, 4}, Element(2));
+  a.get(5, 0) = Element(-1);
+
+  // The band holding row 5 throws, every other band still finishes or
+  // skips its work so the launch drains
+  auto pool = async::ThreadPool(3);
+  auto expr = async::Add(async::AddScalar(async::Add(a, b), 1), b);
+  auto future = async::Launch(pool, expr, {2});
+
+  REQUIRE_THROWS_AS(future.get(), std::domain_error);
+  REQUIRE(future.ready());
+
+  a.get(5, 0) = Element(1);
+  auto fixed = async::Launch(pool, expr, {2});
+  REQUIRE(fixed.get() == Matrix2D<Element>({8, 4}, Element(6)));
+}
+
+TEST_CASE("async failure waits for running bands", "[async]") {
+  namespace async = cpp_matrix::async;
+
+  auto slow_source = Matrix2D<SlowElement>({2, 4}, SlowElement(1));
+  auto bad_source = Matrix2D<SlowElement>({2, 4}, SlowElement(-1));
+
+  // The slow bands are queued first and are still multiplying when the
+  // third thread fails on a bad band
+  auto pool = async::ThreadPool(3);
+  auto slow = async::MultScalar(slow_source, SlowElement(2));
+  auto bad = async::Sub(bad_source, bad_source);
+  auto future = async::Launch(pool, async::Add(slow, bad), {1});
+
+  REQUIRE_THROWS_AS(future.get(), std::domain_error);
+  REQUIRE(SlowElement::active == 0);
+}
+
+TEST_CASE("async frees intermediates once consumed", "[async]") {
+  namespace async = cpp_matrix::async;
+
+  constexpr long kElements = 10 * 10;
+  constexpr int kSteps = 6;
+
+  {
+    auto source = Matrix2D<Element>({10, 10}, Element(1));
+    auto expr = async::Expr<Element>(source);
+    for (int i = 0; i < kSteps; i++) {
+      expr = async::AddScalar(expr, Element(1));
+    }
+
+    // One thread and one band per node run the chain in order, so at most
+    // the node being computed and its input are alive next to the source
+    auto pool = async::ThreadPool(1);
+    Element::peak = Element::live.load();
+    long before = Element::live;
+
+    auto future = async::Launch(pool, expr, {10});
+    const auto& result = future.get();
+    long peak = Element::peak - before;
+
+    // Keeping every intermediate would peak at kSteps * kElements
+    REQUIRE(peak < 3 * kElements);
+    REQUIRE(result == Matrix2D<Element>({10, 10}, Element(1 + kSteps)));
+  }
+
+  REQUIRE(Element::live == 0);
+}
@@ -2,6 +2,7 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include "cpp_matrix.hpp"
+#include "parallel.hpp"
 using namespace qustrolabe;
 
 TEST_CASE("Initialization", "[matrix2d]") {
@@ -350,4 +351,240 @@ TEST_CASE("Dot product", "[matrix2d]") {
     REQUIRE(result.get(1, 0) == 43);
     REQUIRE(result.get(1, 1) == 50);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Column-major layout", "[matrix2d]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::Matrix2D;
+  using SizeType = Matrix2D<int>::SizeType;
+
+  auto matrix = Matrix2D<int, ColMajor>({2, 3});
+  int counter = 0;
+  for (SizeType row = 0; row < matrix.rows(); row++) {
+    for (SizeType col = 0; col < matrix.cols(); col++) {
+      matrix.get(row, col) = counter++;
+    }
+  }
+
+  // 0 1 2
+  // 3 4 5
+  REQUIRE(matrix.data() == std::vector<int>{0, 3, 1, 4, 2, 5});
+
+  SECTION("cols iterate over contiguous storage") {
+    std::vector<int> result{};
+    for (auto& col : matrix.getCols()) {
+      for (auto& e : col) {
+        result.push_back(e);
+      }
+    }
+
+    REQUIRE(result == matrix.data());
+  }
+
+  SECTION("transpose keeps layout") {
+    auto transposed = cpp_matrix::Transpose(matrix);
+
+    REQUIRE(transposed.shape() == cpp_matrix::Shape2D<int>{3, 2});
+    REQUIRE(transposed.data() == std::vector<int>{0, 1, 2, 3, 4, 5});
+  }
+}
+
+TEST_CASE("Layout conversion", "[matrix2d]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::ConvertLayout;
+  using cpp_matrix::Rand2D;
+  using cpp_matrix::RowMajor;
+  using SizeType = cpp_matrix::Matrix2D<int>::SizeType;
+
+  auto matrix = Rand2D<int>({37, 70});  // not a multiple of the tile size
+  auto col_major = ConvertLayout<ColMajor>(matrix);
+
+  for (SizeType row = 0; row < matrix.rows(); row++) {
+    for (SizeType col = 0; col < matrix.cols(); col++) {
+      REQUIRE(col_major.get(row, col) == matrix.get(row, col));
+    }
+  }
+
+  REQUIRE(ConvertLayout<RowMajor>(col_major) == matrix);
+}
+
+TEST_CASE("Mixed layout operations", "[matrix2d]") {
+  using cpp_matrix::Add;
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::ConvertLayout;
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Rand2D;
+  using cpp_matrix::RowMajor;
+  using cpp_matrix::Sub;
+  using SizeType = Matrix2D<int>::SizeType;
+
+  auto lhs = Rand2D<int>({7, 5});
+  auto rhs = Rand2D<int>({5, 4});
+  auto expected = DotProduct2D(lhs, rhs);
+
+  auto lhs_col = ConvertLayout<ColMajor>(lhs);
+  auto rhs_col = ConvertLayout<ColMajor>(rhs);
+
+  SECTION("dot product in every layout combination") {
+    REQUIRE(DotProduct2D(lhs, rhs_col) == expected);
+    REQUIRE(ConvertLayout<RowMajor>(DotProduct2D(lhs_col, rhs)) == expected);
+    REQUIRE(ConvertLayout<RowMajor>(DotProduct2D(lhs_col, rhs_col)) ==
+            expected);
+
+    for (SizeType i = 0; i < expected.rows(); i++) {
+      for (SizeType j = 0; j < expected.cols(); j++) {
+        int sum = 0;
+        for (SizeType k = 0; k < lhs.cols(); k++) {
+          sum += lhs.get(i, k) * rhs.get(k, j);
+        }
+        REQUIRE(expected.get(i, j) == sum);
+      }
+    }
+  }
+
+  SECTION("addition and subtraction") {
+    auto other = Rand2D<int, ColMajor>({7, 5});
+    auto sum = Add(lhs, other);
+    auto difference = Sub(lhs, other);
+
+    for (SizeType row = 0; row < lhs.rows(); row++) {
+      for (SizeType col = 0; col < lhs.cols(); col++) {
+        REQUIRE(sum.get(row, col) == lhs.get(row, col) + other.get(row, col));
+        REQUIRE(difference.get(row, col) ==
+                lhs.get(row, col) - other.get(row, col));
+      }
+    }
+  }
+}
+
+TEST_CASE("Map", "[matrix2d]") {
+  using cpp_matrix::Map;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Rand2D;
+
+  auto matrix = Rand2D<int>({4, 6});
+
+  SECTION("converts to a matrix") {
+    Matrix2D<int> squared = Map(matrix, [](int x) { return x * x; });
+
+    for (std::size_t i = 0; i < matrix.data().size(); i++) {
+      REQUIRE(squared.data()[i] == matrix.data()[i] * matrix.data()[i]);
+    }
+  }
+
+  SECTION("result type follows the function") {
+    auto halves = Evaluate(Map(matrix, [](int x) { return x / 2.0; }));
+    auto positive = Evaluate(Map(matrix, [](int x) { return x > 0; }));
+
+    static_assert(std::is_same_v<decltype(halves), Matrix2D<double>>);
+    static_assert(std::is_same_v<decltype(positive), Matrix2D<bool>>);
+    REQUIRE(halves.get(1, 1) == matrix.get(1, 1) / 2.0);
+    REQUIRE(positive.data()[23]);
+  }
+
+  SECTION("temporaries are kept alive") {
+    auto expr = Map(Rand2D<int>({2, 2}), [](int x) { return -x; });
+    Matrix2D<int> negated = expr;
+
+    for (const auto& e : negated.data()) {
+      REQUIRE(e < 0);
+    }
+  }
+
+  SECTION("column-major") {
+    auto col_major = cpp_matrix::ConvertLayout<cpp_matrix::ColMajor>(matrix);
+    auto doubled = Evaluate(Map(col_major, [](int x) { return 2 * x; }));
+
+    REQUIRE(doubled.get(2, 3) == 2 * matrix.get(2, 3));
+  }
+}
+
+TEST_CASE("ZipWith and fusion", "[matrix2d]") {
+  using cpp_matrix::Map;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Rand2D;
+  using cpp_matrix::ZipWith;
+  using SizeType = Matrix2D<int>::SizeType;
+
+  auto x = Rand2D<int>({5, 3});
+  auto y = Rand2D<int>({5, 3});
+
+  SECTION("fused a*x+b then clamp") {
+    auto fma = ZipWith(x, y, [](int x, int y) { return 3 * x + y; });
+    Matrix2D<int> clamped = Map(fma, [](int v) { return std::min(v, 20); });
+
+    for (SizeType row = 0; row < x.rows(); row++) {
+      for (SizeType col = 0; col < x.cols(); col++) {
+        REQUIRE(clamped.get(row, col) ==
+                std::min(3 * x.get(row, col) + y.get(row, col), 20));
+      }
+    }
+  }
+
+  SECTION("comparison") {
+    auto less = Evaluate(ZipWith(x, y, [](int x, int y) { return x < y; }));
+
+    REQUIRE(less.data()[14] == (x.get(4, 2) < y.get(4, 2)));
+  }
+
+  SECTION("nested expressions on both sides") {
+    auto negate = [](int v) { return -v; };
+    auto sum = Evaluate(ZipWith(Map(x, negate), Map(x, negate),
+                                [](int a, int b) { return a + b; }));
+
+    REQUIRE(sum.get(0, 0) == -2 * x.get(0, 0));
+  }
+
+  SECTION("shape mismatch") {
+    auto other = Rand2D<int>({3, 5});
+
+    REQUIRE_THROWS_AS(ZipWith(x, other, [](int a, int b) { return a + b; }),
+                      cpp_matrix::ShapeMismatchException);
+  }
+}
+
+TEST_CASE("Apply and execution policies", "[matrix2d]") {
+  using cpp_matrix::Apply;
+  using cpp_matrix::Map;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Rand2D;
+
+  auto matrix = Rand2D<int>({64, 64});
+  auto original = matrix;
+  auto relu = [](int v) { return v > 5 ? v : 0; };
+
+  SECTION("in place") {
+    Apply(matrix, relu);
+
+    for (std::size_t i = 0; i < matrix.data().size(); i++) {
+      REQUIRE(matrix.data()[i] == relu(original.data()[i]));
+    }
+  }
+
+  SECTION("parallel") {
+    Apply(std::execution::par_unseq, matrix, relu);
+    auto evaluated = Evaluate(std::execution::par, Map(original, relu));
+
+    REQUIRE(matrix == evaluated);
+  }
+
+  SECTION("parallel over several blocks") {
+    auto large = Rand2D<int>({300, 70});
+    auto expected = large;
+    Apply(expected, relu);
+
+    Apply(std::execution::par, large, relu);
+    REQUIRE(large == expected);
+  }
+
+  SECTION("parallel bool") {
+    auto mask = Evaluate(std::execution::par,
+                         Map(original, [](int v) { return v > 5; }));
+    Apply(std::execution::par, mask, [](bool v) { return !v; });
+
+    for (std::size_t i = 0; i < mask.data().size(); i++) {
+      REQUIRE(mask.data()[i] == (original.data()[i] <= 5));
+    }
+  }
+}
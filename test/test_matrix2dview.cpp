@@ -0,0 +1,95 @@
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+TEST_CASE("Matrix2DView over matrices", "[matrix2dview]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Matrix2DView;
+  using cpp_matrix::Rand2D;
+  using SizeType = Matrix2D<int>::SizeType;
+
+  SECTION("row-major") {
+    auto matrix = Rand2D<int>({3, 4});
+    auto view = Matrix2DView(matrix);
+
+    REQUIRE(view.rowStride() == 4);
+    REQUIRE(view.colStride() == 1);
+
+    view.get(2, 1) = 42;
+    REQUIRE(matrix.get(2, 1) == 42);
+  }
+
+  SECTION("column-major") {
+    auto matrix = Rand2D<int, ColMajor>({3, 4});
+    const auto& const_matrix = matrix;
+    auto view = Matrix2DView(const_matrix);
+
+    REQUIRE(view.rowStride() == 1);
+    REQUIRE(view.colStride() == 3);
+
+    for (SizeType row = 0; row < matrix.rows(); row++) {
+      for (SizeType col = 0; col < matrix.cols(); col++) {
+        REQUIRE(view.get(row, col) == matrix.get(row, col));
+      }
+    }
+  }
+}
+
+TEST_CASE("Matrix2DView over foreign buffers", "[matrix2dview]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::Matrix2DView;
+  using cpp_matrix::ToMatrix2D;
+
+  // Fortran-ordered 2x3 matrix
+  // 1 3 5
+  // 2 4 6
+  std::vector<int> buffer{1, 2, 3, 4, 5, 6};
+  auto view = Matrix2DView<int>(buffer.data(), {2, 3}, 1, 2);
+
+  REQUIRE(view.get(0, 2) == 5);
+  REQUIRE(view.get(1, 0) == 2);
+  REQUIRE_THROWS_AS(view.get(2, 0), std::out_of_range);
+
+  SECTION("copy into either layout") {
+    auto row_major = ToMatrix2D(view);
+    auto col_major = ToMatrix2D<ColMajor>(view);
+
+    REQUIRE(row_major.data() == std::vector<int>{1, 3, 5, 2, 4, 6});
+    REQUIRE(col_major.data() == buffer);
+  }
+
+  SECTION("custom strides") {
+    // every other column of the buffer above
+    auto strided = Matrix2DView<const int>(buffer.data(), {2, 2}, 1, 4);
+
+    REQUIRE(strided.get(0, 0) == 1);
+    REQUIRE(strided.get(1, 1) == 6);
+  }
+}
+
+#ifdef __cpp_lib_mdspan
+TEST_CASE("Matrix2DView mdspan interop", "[matrix2dview]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Matrix2DView;
+  using cpp_matrix::Rand2D;
+
+  auto matrix = Rand2D<int, ColMajor>({3, 5});
+  auto span = matrix.mdspan();
+
+  REQUIRE(span.data_handle() == matrix.data().data());
+  REQUIRE(span[2, 4] == matrix.get(2, 4));
+
+  auto view = Matrix2DView(span);
+  REQUIRE(view.data() == matrix.data().data());
+  REQUIRE(view.get(1, 3) == matrix.get(1, 3));
+
+  auto strided = view.mdspan();
+  REQUIRE(strided.data_handle() == matrix.data().data());
+  REQUIRE(strided[1, 3] == matrix.get(1, 3));
+}
+#endif
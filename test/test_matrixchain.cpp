@@ -0,0 +1,152 @@
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+TEST_CASE("Chain planning", "[matrixchain]") {
+  using cpp_matrix::PlanChain;
+  using cpp_matrix::Shape2D;
+
+  SECTION("textbook chain") {
+    // CLRS 15.2: optimal order is ((A1(A2A3))((A4A5)A6)) with 15125 mults
+    auto plan = PlanChain({{30, 35},
+                           {35, 15},
+                           {15, 5},
+                           {5, 10},
+                           {10, 20},
+                           {20, 25}});
+
+    REQUIRE(plan.multiplications == 15125);
+    REQUIRE(plan.steps.size() == 5);
+
+    // operands 0..5 are inputs, 6.. are step results
+    REQUIRE(plan.steps[0].lhs == 1);
+    REQUIRE(plan.steps[0].rhs == 2);
+    REQUIRE(plan.steps[1].lhs == 0);
+    REQUIRE(plan.steps[1].rhs == 6);
+    REQUIRE(plan.steps[2].lhs == 3);
+    REQUIRE(plan.steps[2].rhs == 4);
+    REQUIRE(plan.steps[3].lhs == 8);
+    REQUIRE(plan.steps[3].rhs == 5);
+    REQUIRE(plan.steps[4].lhs == 7);
+    REQUIRE(plan.steps[4].rhs == 9);
+  }
+
+  SECTION("intermediate buffers are reused") {
+    auto plan = PlanChain({{30, 35},
+                           {35, 15},
+                           {15, 5},
+                           {5, 10},
+                           {10, 20},
+                           {20, 25}});
+
+    // 5 products, but never more than 3 values alive at once
+    REQUIRE(plan.buffer_elements.size() < plan.steps.size());
+    for (const auto& step : plan.steps) {
+      REQUIRE(step.buffer < plan.buffer_elements.size());
+    }
+  }
+
+  SECTION("shape mismatch") {
+    REQUIRE_THROWS_AS(PlanChain({{2, 3}, {4, 5}}),
+                      cpp_matrix::ShapeMismatchException);
+  }
+}
+
+TEST_CASE("Chain plan cache", "[matrixchain]") {
+  using cpp_matrix::ChainPlanCache;
+  using cpp_matrix::Shape2D;
+
+  auto cache = ChainPlanCache(4);
+  auto chain = [](int n) {
+    return std::vector<Shape2D<int>>{{n, 2}, {2, n}, {n, 3}};
+  };
+
+  const auto* first = &cache.get(chain(1));
+  REQUIRE(&cache.get(chain(1)) == first);
+  REQUIRE(cache.size() == 1);
+
+  // Least recently used goes first: 1 is touched, so 2 is evicted
+  for (int n = 2; n <= 4; n++) {
+    cache.get(chain(n));
+  }
+  cache.get(chain(1));
+  cache.get(chain(5));
+
+  REQUIRE(cache.size() == 4);
+  REQUIRE(&cache.get(chain(1)) == first);
+  REQUIRE(cache.get(chain(2)).multiplications ==
+          cpp_matrix::PlanChain(chain(2)).multiplications);
+  REQUIRE(cache.size() == 4);
+
+  REQUIRE_THROWS_AS(cache.get({{2, 3}, {4, 5}}),
+                    cpp_matrix::ShapeMismatchException);
+  REQUIRE(cache.size() == 4);
+
+  cache.clear();
+  REQUIRE(cache.size() == 0);
+  REQUIRE(cpp_matrix::LocalChainPlanCache().capacity() == 64);
+}
+
+TEST_CASE("MultiplyChain", "[matrixchain]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::ConvertLayout;
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::MultiplyChain;
+  using cpp_matrix::Rand2D;
+
+  auto a = Rand2D<int>({10, 2});
+  auto b = Rand2D<int>({2, 30});
+  auto c = Rand2D<int>({30, 3});
+  auto d = Rand2D<int>({3, 7});
+
+  auto expected = DotProduct2D(DotProduct2D(DotProduct2D(a, b), c), d);
+
+  SECTION("variadic") {
+    REQUIRE(MultiplyChain(a, b, c, d) == expected);
+    // second call goes through the cached plan
+    REQUIRE(MultiplyChain(a, b, c, d) == expected);
+  }
+
+  SECTION("vector") {
+    REQUIRE(MultiplyChain(std::vector{a, b, c, d}) == expected);
+    REQUIRE_THROWS_AS(MultiplyChain(std::vector<Matrix2D<int>>{}),
+                      std::invalid_argument);
+  }
+
+  SECTION("column-major") {
+    auto result = MultiplyChain(ConvertLayout<ColMajor>(a),
+                                ConvertLayout<ColMajor>(b),
+                                ConvertLayout<ColMajor>(c),
+                                ConvertLayout<ColMajor>(d));
+
+    REQUIRE(result == ConvertLayout<ColMajor>(expected));
+  }
+
+  SECTION("single operand and pair") {
+    REQUIRE(MultiplyChain(a) == a);
+    REQUIRE(MultiplyChain(a, b) == DotProduct2D(a, b));
+  }
+
+  SECTION("shape mismatch") {
+    REQUIRE_THROWS_AS(MultiplyChain(a, c), cpp_matrix::ShapeMismatchException);
+  }
+}
+
+TEST_CASE("Compile-time MultiplyChain", "[matrixchain]") {
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::Matrix2DArray;
+  using cpp_matrix::MultiplyChain;
+
+  constexpr auto a = Matrix2DArray<int, 4, 1>(2);
+  constexpr auto b = Matrix2DArray<int, 1, 5>(3);
+  constexpr auto c = Matrix2DArray<int, 5, 2>(1);
+
+  constexpr auto result = MultiplyChain(a, b, c);
+  static_assert(result.get(3, 1) == 2 * 3 * 5);
+
+  REQUIRE(result == DotProduct2D(DotProduct2D(a, b), c));
+}
@@ -0,0 +1,167 @@
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <thread>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+#ifdef CPP_MATRIX_PROFILING
+// Declared first so it records the first op of the process
+TEST_CASE("Trace timestamps start at the epoch", "[profiling]") {
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::MultScalar;
+  using cpp_matrix::profiling::ExportChromeTrace;
+
+  auto matrix = MultScalar(Matrix2D<int>({3, 3}), 2);
+
+  auto trace = ExportChromeTrace();
+  auto ts = trace.find("\"ts\":");
+  REQUIRE(ts != std::string::npos);
+
+  // Microseconds since the registry was created, a wrapped start time
+  // shows up as ~1.8e13 seconds
+  auto microseconds = std::stod(trace.substr(ts + 5));
+  REQUIRE(microseconds >= 0.0);
+  REQUIRE(microseconds < 60e6);
+}
+
+TEST_CASE("Op counters", "[profiling]") {
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::profiling::Op;
+  using cpp_matrix::profiling::OpStats;
+  using cpp_matrix::profiling::TakeSnapshot;
+
+  auto lhs = Matrix2D<int>({2, 3}, 1);
+  auto rhs = Matrix2D<int>({3, 4}, 1);
+  cpp_matrix::profiling::Reset();
+
+  SECTION("elementwise") {
+    auto sum = Add(lhs, lhs);
+    auto stats = TakeSnapshot().Total(Op::Add);
+
+    REQUIRE(stats.calls == 1);
+    REQUIRE(stats.elements == 6);
+    REQUIRE(stats.flops == 6);
+    REQUIRE(stats.bytes_allocated == 6 * sizeof(int));
+  }
+
+  SECTION("dot product") {
+    auto result = DotProduct2D(lhs, rhs);
+    result = DotProduct2D(lhs, rhs);
+    auto stats = TakeSnapshot().Total(Op::DotProduct2D);
+
+    REQUIRE(stats.calls == 2);
+    REQUIRE(stats.elements == 2 * 8);
+    REQUIRE(stats.flops == 2 * (2 * 2 * 4 * 3));
+    REQUIRE(stats.bytes_allocated == 2 * 8 * sizeof(int));
+  }
+
+  SECTION("temporaries of nested ops") {
+    auto difference = Sub(lhs, lhs);
+    auto snapshot = TakeSnapshot();
+
+    REQUIRE(snapshot.Total(Op::Sub).calls == 1);
+    REQUIRE(snapshot.Total(Op::MultScalar).calls == 1);
+    REQUIRE(snapshot.Total(Op::Add).calls == 1);
+    REQUIRE(snapshot.Total(Op::Transpose) == OpStats{});
+  }
+
+  SECTION("strassen workspaces") {
+    auto square = Matrix2D<int>({256, 256}, 1);
+    auto options = cpp_matrix::StrassenOptions{.crossover = 64};
+
+    // Result, top level: 8 quarter operands and 7 quarter products, and
+    // per task the same one level down
+    options.parallel = true;
+    cpp_matrix::StrassenDotProduct2D(square, square, options);
+    REQUIRE(TakeSnapshot().Total(Op::StrassenDotProduct2D).bytes_allocated ==
+            (65536 + 15 * 128 * 128 + 7 * 15 * 64 * 64) * sizeof(int));
+
+    // Sequential: one workspace for both levels
+    cpp_matrix::profiling::Reset();
+    options.parallel = false;
+    cpp_matrix::StrassenDotProduct2D(square, square, options);
+    REQUIRE(TakeSnapshot().Total(Op::StrassenDotProduct2D).bytes_allocated ==
+            (65536 + 15 * 128 * 128 + 15 * 64 * 64) * sizeof(int));
+  }
+
+  SECTION("failed ops are not counted") {
+    REQUIRE_THROWS(DotProduct2D(lhs, lhs));
+    REQUIRE(TakeSnapshot().Total(Op::DotProduct2D).calls == 0);
+  }
+}
+
+TEST_CASE("Per-thread counters", "[profiling]") {
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Transpose;
+  using cpp_matrix::profiling::Op;
+  using cpp_matrix::profiling::TakeSnapshot;
+
+  auto matrix = Matrix2D<int>({5, 7});
+  cpp_matrix::profiling::Reset();
+
+  auto worker = std::thread([&] {
+    for (int i = 0; i < 3; i++) {
+      auto transposed = Transpose(matrix);
+    }
+  });
+  worker.join();
+  auto transposed = Transpose(matrix);
+
+  auto snapshot = TakeSnapshot();
+  REQUIRE(snapshot.threads.size() >= 2);
+  REQUIRE(snapshot.Total(Op::Transpose).calls == 4);
+  REQUIRE(snapshot.Total(Op::Transpose).elements == 4 * 35);
+
+  int threads_with_transposes = 0;
+  for (const auto& thread : snapshot.threads) {
+    auto calls = thread[Op::Transpose].calls;
+    REQUIRE((calls == 0 or calls == 1 or calls == 3));
+    threads_with_transposes += calls != 0;
+  }
+  REQUIRE(threads_with_transposes == 2);
+}
+
+TEST_CASE("Profiles of exited threads are reused", "[profiling]") {
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Transpose;
+  using cpp_matrix::profiling::Op;
+  using cpp_matrix::profiling::TakeSnapshot;
+
+  auto matrix = Matrix2D<int>({2, 2});
+  auto run_thread = [&] {
+    std::thread([&] { auto transposed = Transpose(matrix); }).join();
+  };
+
+  run_thread();
+  auto threads = TakeSnapshot().threads.size();
+  for (int i = 0; i < 16; i++) {
+    run_thread();
+  }
+
+  REQUIRE(TakeSnapshot().threads.size() == threads);
+}
+
+TEST_CASE("Exporters", "[profiling]") {
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::MultScalar;
+  using cpp_matrix::profiling::ExportChromeTrace;
+  using cpp_matrix::profiling::ExportJson;
+  using cpp_matrix::profiling::TakeSnapshot;
+
+  cpp_matrix::profiling::Reset();
+  auto matrix = MultScalar(Matrix2D<int>({3, 3}), 2);
+
+  auto trace = ExportChromeTrace();
+  REQUIRE(trace.starts_with("{\"traceEvents\":[{\"name\":\"MultScalar\""));
+  REQUIRE(trace.find("\"ph\":\"X\"") != std::string::npos);
+  REQUIRE(trace.find("\"elements\":9") != std::string::npos);
+
+  auto json = ExportJson(TakeSnapshot());
+  REQUIRE(json.find("\"MultScalar\":{\"calls\":1,\"elements\":9") !=
+          std::string::npos);
+  REQUIRE(json.find("\"Add\"") == std::string::npos);
+}
+#endif
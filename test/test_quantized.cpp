@@ -0,0 +1,205 @@
+
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+TEST_CASE("Float16 conversion", "[quantized]") {
+  using cpp_matrix::Float16;
+
+  SECTION("exact values") {
+    REQUIRE(Float16(0.0f).bits() == 0x0000);
+    REQUIRE(Float16(1.0f).bits() == 0x3c00);
+    REQUIRE(Float16(-2.0f).bits() == 0xc000);
+    REQUIRE(Float16(65504.0f).bits() == 0x7bff);
+    REQUIRE(Float16(0x1p-24f).bits() == 0x0001);  // smallest subnormal
+
+    REQUIRE(static_cast<float>(Float16::FromBits(0x3555)) ==
+            0.333251953125f);
+    REQUIRE(static_cast<float>(Float16::FromBits(0x0001)) == 0x1p-24f);
+  }
+
+  SECTION("rounding and overflow") {
+    REQUIRE(Float16(1.0f + 0x1p-11f).bits() == 0x3c00);  // tie to even
+    REQUIRE(Float16(1.0f + 0x1p-10f + 0x1p-11f).bits() == 0x3c02);
+    REQUIRE(Float16(70000.0f).bits() == 0x7c00);
+    REQUIRE(Float16(1e-9f).bits() == 0x0000);
+    REQUIRE(std::isinf(static_cast<float>(
+        Float16(std::numeric_limits<float>::infinity()))));
+    REQUIRE(std::isnan(static_cast<float>(
+        Float16(std::numeric_limits<float>::quiet_NaN()))));
+  }
+
+  SECTION("round trip") {
+    for (std::uint32_t bits = 0; bits < 0x7c00; bits++) {
+      auto half = Float16::FromBits(static_cast<std::uint16_t>(bits));
+      REQUIRE(Float16(static_cast<float>(half)).bits() == half.bits());
+    }
+  }
+
+  SECTION("comparisons follow float") {
+    REQUIRE(Float16(1.0f) == 1.0f);
+    REQUIRE(Float16(0.0f) == Float16(-0.0f));
+    REQUIRE(Float16(0.0f).bits() != Float16(-0.0f).bits());
+
+    auto nan = Float16(std::numeric_limits<float>::quiet_NaN());
+    REQUIRE_FALSE(nan == nan);
+  }
+}
+
+TEST_CASE("BFloat16 conversion", "[quantized]") {
+  using cpp_matrix::BFloat16;
+
+  REQUIRE(BFloat16(1.0f).bits() == 0x3f80);
+  REQUIRE(BFloat16(-3.0f).bits() == 0xc040);
+  REQUIRE(static_cast<float>(BFloat16(3.140625f)) == 3.140625f);
+  REQUIRE(BFloat16(1.0f + 0x1p-8f).bits() == 0x3f80);  // tie to even
+  REQUIRE(std::isnan(static_cast<float>(
+      BFloat16(std::numeric_limits<float>::quiet_NaN()))));
+  REQUIRE(BFloat16(2.0f) == 2.0f);
+}
+
+TEST_CASE("Mixed precision dot product", "[quantized]") {
+  using cpp_matrix::Float16;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::MixedDotProduct2D;
+
+  SECTION("int8 accumulates in int32") {
+    auto lhs = Matrix2D<std::int8_t>({3, 64}, 100);
+    auto rhs = Matrix2D<std::int8_t>({64, 2}, -100);
+
+    auto result = MixedDotProduct2D<std::int32_t>(lhs, rhs);
+
+    REQUIRE(result.shape() == cpp_matrix::Shape2D<int>{3, 2});
+    for (const auto& e : result.data()) {
+      REQUIRE(e == 64 * 100 * -100);
+    }
+  }
+
+  SECTION("fp16 accumulates in fp32") {
+    auto lhs = Matrix2D<Float16>({1, 4096}, Float16(1.0f));
+    auto rhs = Matrix2D<Float16>({4096, 1}, Float16(1.0f));
+
+    // a Float16 accumulator would get stuck at 2048
+    auto result = MixedDotProduct2D<float>(lhs, rhs);
+
+    REQUIRE(result.get(0, 0) == 4096.0f);
+  }
+
+  SECTION("shape mismatch") {
+    auto lhs = Matrix2D<std::int8_t>({2, 3});
+    auto rhs = Matrix2D<std::int8_t>({2, 3});
+
+    REQUIRE_THROWS_AS(MixedDotProduct2D<std::int32_t>(lhs, rhs),
+                      cpp_matrix::ShapeMismatchException);
+  }
+}
+
+TEST_CASE("Quantize and dequantize", "[quantized]") {
+  using cpp_matrix::Dequantize;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Quantize;
+  using cpp_matrix::QuantizationAxis;
+  using SizeType = Matrix2D<float>::SizeType;
+
+  auto matrix = Matrix2D<float>({4, 6});
+  for (SizeType row = 0; row < matrix.rows(); row++) {
+    for (SizeType col = 0; col < matrix.cols(); col++) {
+      matrix.get(row, col) = (row + 1) * 0.37f * (col - 2.5f);
+    }
+  }
+
+  SECTION("per row") {
+    auto quantized = Quantize(matrix, QuantizationAxis::Rows);
+    REQUIRE(quantized.scales().size() == 4);
+
+    auto restored = Dequantize(quantized);
+    for (SizeType row = 0; row < matrix.rows(); row++) {
+      for (SizeType col = 0; col < matrix.cols(); col++) {
+        REQUIRE(std::abs(restored.get(row, col) - matrix.get(row, col)) <=
+                quantized.scales()[row] * 0.5f + 1e-6f);
+      }
+    }
+  }
+
+  SECTION("per col") {
+    auto quantized = Quantize(matrix, QuantizationAxis::Cols);
+    REQUIRE(quantized.scales().size() == 6);
+
+    auto restored = Dequantize(quantized);
+    for (SizeType row = 0; row < matrix.rows(); row++) {
+      for (SizeType col = 0; col < matrix.cols(); col++) {
+        REQUIRE(std::abs(restored.get(row, col) - matrix.get(row, col)) <=
+                quantized.scales()[col] * 0.5f + 1e-6f);
+      }
+    }
+  }
+
+  SECTION("zero is exact") {
+    auto zeros = Matrix2D<float>({2, 2});
+    auto restored = Dequantize(Quantize(zeros, QuantizationAxis::Rows));
+
+    REQUIRE(restored == zeros);
+  }
+
+  SECTION("non-finite values are rejected") {
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+    for (float bad : {kInf, -kInf, kNaN}) {
+      auto row = Matrix2D<float>({1, 3});
+      row.data() = {1.0f, bad, -2.0f};
+
+      REQUIRE_THROWS_AS(Quantize(row, QuantizationAxis::Rows),
+                        std::invalid_argument);
+      REQUIRE_THROWS_AS(Quantize(row, QuantizationAxis::Cols),
+                        std::invalid_argument);
+    }
+  }
+}
+
+TEST_CASE("Quantized dot product", "[quantized]") {
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::Matrix2D;
+  using cpp_matrix::Quantize;
+  using cpp_matrix::QuantizationAxis;
+  using cpp_matrix::QuantizedDotProduct2D;
+  using SizeType = Matrix2D<float>::SizeType;
+
+  auto lhs = Matrix2D<float>({5, 16});
+  auto rhs = Matrix2D<float>({16, 3});
+  for (SizeType row = 0; row < lhs.rows(); row++) {
+    for (SizeType col = 0; col < lhs.cols(); col++) {
+      lhs.get(row, col) = std::sin(row * 16.0f + col);
+    }
+  }
+  for (SizeType row = 0; row < rhs.rows(); row++) {
+    for (SizeType col = 0; col < rhs.cols(); col++) {
+      rhs.get(row, col) = std::cos(row * 3.0f + col) * 2.0f + 0.5f;
+    }
+  }
+
+  auto q_lhs = Quantize(lhs, QuantizationAxis::Rows);
+  auto q_rhs = Quantize(rhs, QuantizationAxis::Cols);
+
+  auto expected = DotProduct2D(lhs, rhs);
+  auto result = QuantizedDotProduct2D(q_lhs, q_rhs);
+
+  REQUIRE(result.shape() == expected.shape());
+  for (SizeType row = 0; row < result.rows(); row++) {
+    for (SizeType col = 0; col < result.cols(); col++) {
+      REQUIRE(std::abs(result.get(row, col) - expected.get(row, col)) < 0.1f);
+    }
+  }
+
+  SECTION("axis requirement") {
+    auto wrong_rhs = Quantize(rhs, QuantizationAxis::Rows);
+
+    REQUIRE_THROWS_AS(QuantizedDotProduct2D(q_lhs, wrong_rhs),
+                      std::invalid_argument);
+  }
+}
@@ -0,0 +1,120 @@
+
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+namespace {
+
+using cpp_matrix::Matrix2D;
+
+Matrix2D<double> RandomUnit(cpp_matrix::Shape2D<int> shape, unsigned seed) {
+  std::minstd_rand engine(seed);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  auto result = Matrix2D<double>(shape);
+  for (auto& e : result.data()) {
+    e = distribution(engine);
+  }
+  return result;
+}
+
+double MaxAbs(const Matrix2D<double>& matrix) {
+  double result = 0.0;
+  for (auto e : matrix.data()) {
+    result = std::max(result, std::abs(e));
+  }
+  return result;
+}
+
+double MaxAbsDifference(const Matrix2D<double>& lhs,
+                        const Matrix2D<double>& rhs) {
+  double result = 0.0;
+  for (std::size_t i = 0; i < lhs.data().size(); i++) {
+    result = std::max(result, std::abs(lhs.data()[i] - rhs.data()[i]));
+  }
+  return result;
+}
+
+// Higham, "Accuracy and Stability of Numerical Algorithms", Thm 23.4:
+// Winograd's variant with n0 cutoff, in the max norm,
+// |C - C'| <= [(n/n0)^log2(18) (n0^2 + 6 n0) - 6n] u |A| |B|
+double WinogradErrorBound(double n, double n0, double lhs_max,
+                          double rhs_max) {
+  double u = std::numeric_limits<double>::epsilon() / 2;
+  double growth =
+      std::pow(n / n0, std::log2(18.0)) * (n0 * n0 + 6 * n0) - 6 * n;
+  return growth * u * lhs_max * rhs_max;
+}
+
+}  // namespace
+
+TEST_CASE("Strassen exact on integers", "[strassen]") {
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::Rand2D;
+  using cpp_matrix::StrassenDotProduct2D;
+  using cpp_matrix::StrassenOptions;
+
+  SECTION("even sizes, several levels") {
+    auto lhs = Rand2D<long long>({64, 64});
+    auto rhs = Rand2D<long long>({64, 64});
+
+    REQUIRE(StrassenDotProduct2D(lhs, rhs, StrassenOptions{8, false}) ==
+            DotProduct2D(lhs, rhs));
+  }
+
+  SECTION("odd and rectangular sizes are peeled") {
+    auto lhs = Rand2D<long long>({45, 37});
+    auto rhs = Rand2D<long long>({37, 51});
+
+    REQUIRE(StrassenDotProduct2D(lhs, rhs, StrassenOptions{4, false}) ==
+            DotProduct2D(lhs, rhs));
+    REQUIRE(StrassenDotProduct2D(lhs, rhs, StrassenOptions{4, true}) ==
+            DotProduct2D(lhs, rhs));
+  }
+
+  SECTION("below the crossover") {
+    auto lhs = Rand2D<int>({3, 5});
+    auto rhs = Rand2D<int>({5, 2});
+
+    REQUIRE(StrassenDotProduct2D(lhs, rhs) == DotProduct2D(lhs, rhs));
+  }
+
+  SECTION("shape mismatch") {
+    auto lhs = Rand2D<int>({3, 5});
+
+    REQUIRE_THROWS_AS(StrassenDotProduct2D(lhs, lhs),
+                      cpp_matrix::ShapeMismatchException);
+  }
+}
+
+TEST_CASE("Strassen error bound", "[strassen]") {
+  using cpp_matrix::DotProduct2D;
+  using cpp_matrix::StrassenDotProduct2D;
+  using cpp_matrix::StrassenOptions;
+
+  for (int n : {64, 96, 127}) {
+    for (int crossover : {8, 16, 32}) {
+      auto lhs = RandomUnit({n, n}, 2 * n + 1);
+      auto rhs = RandomUnit({n, n}, 3 * n + 7);
+
+      auto classic = DotProduct2D(lhs, rhs);
+      auto fast = StrassenDotProduct2D(lhs, rhs, StrassenOptions{crossover});
+
+      double lhs_max = MaxAbs(lhs);
+      double rhs_max = MaxAbs(rhs);
+      double u = std::numeric_limits<double>::epsilon() / 2;
+
+      // the classic result itself is only accurate to n u |A| |B|
+      double bound = WinogradErrorBound(n, crossover, lhs_max, rhs_max) +
+                     n * u * lhs_max * rhs_max;
+
+      INFO("n = " << n << ", crossover = " << crossover);
+      REQUIRE(MaxAbsDifference(fast, classic) <= bound);
+    }
+  }
+}
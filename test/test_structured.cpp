@@ -0,0 +1,280 @@
+#include <catch2/catch_test_macros.hpp>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpp_matrix.hpp"
+using namespace qustrolabe;
+
+namespace {
+
+using cpp_matrix::Matrix2D;
+
+// Deterministic small integers, exact under every kernel
+template <typename Layout = cpp_matrix::RowMajor>
+Matrix2D<int, Layout> Filled(cpp_matrix::Shape2D<int> shape, int seed) {
+  auto result = Matrix2D<int, Layout>(shape);
+  for (int row = 0; row < shape.rows; row++) {
+    for (int col = 0; col < shape.cols; col++) {
+      result.get(row, col) = (row * 7 + col * 3 + seed) % 11 - 5;
+    }
+  }
+  return result;
+}
+
+Matrix2D<int> Symmetrized(const Matrix2D<int>& matrix) {
+  return cpp_matrix::Add(matrix, cpp_matrix::Transpose(matrix));
+}
+
+}  // namespace
+
+TEST_CASE("SymmetricMatrix packs the lower triangle", "[structured]") {
+  using cpp_matrix::SymmetricMatrix;
+
+  auto dense = Symmetrized(Filled({5, 5}, 1));
+  auto packed = SymmetricMatrix<int>(dense);
+
+  REQUIRE(packed.data().size() == 15);
+  REQUIRE(packed.shape() == dense.shape());
+  REQUIRE(cpp_matrix::ToMatrix2D(packed) == dense);
+
+  for (int row = 0; row < 5; row++) {
+    for (int col = 0; col < 5; col++) {
+      REQUIRE(packed.get(row, col) == dense.get(row, col));
+    }
+  }
+
+  // Both halves are the same element
+  packed.get(1, 3) = 42;
+  REQUIRE(packed.get(3, 1) == 42);
+
+  REQUIRE_THROWS_AS(packed.get(5, 0), std::out_of_range);
+  REQUIRE_THROWS_AS(SymmetricMatrix<int>(Matrix2D<int>({2, 3})),
+                    cpp_matrix::ShapeMismatchException);
+}
+
+TEST_CASE("SymmetricMatrix DotProduct2D and Transpose", "[structured]") {
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::SymmetricMatrix;
+
+  auto dense = Symmetrized(Filled({6, 6}, 2));
+  auto packed = SymmetricMatrix<int>(dense);
+  auto rhs = Filled({6, 4}, 3);
+
+  REQUIRE(cpp_matrix::DotProduct2D(packed, rhs) ==
+          cpp_matrix::DotProduct2D(dense, rhs));
+
+  auto rhs_col = cpp_matrix::ConvertLayout<ColMajor>(rhs);
+  REQUIRE(cpp_matrix::DotProduct2D(packed, rhs_col) ==
+          cpp_matrix::DotProduct2D(cpp_matrix::ConvertLayout<ColMajor>(dense),
+                                   rhs_col));
+
+  // Transpose hands back the same object, a temporary is moved out
+  REQUIRE(&cpp_matrix::Transpose(packed) == &packed);
+  static_assert(std::is_same_v<decltype(cpp_matrix::Transpose(
+                                   SymmetricMatrix<int>(dense))),
+                               SymmetricMatrix<int>>);
+  const auto& transposed = cpp_matrix::Transpose(SymmetricMatrix<int>(dense));
+  REQUIRE(transposed == packed);
+
+  REQUIRE_THROWS_AS(cpp_matrix::DotProduct2D(packed, Filled({5, 2}, 0)),
+                    cpp_matrix::ShapeMismatchException);
+}
+
+TEST_CASE("TriangularMatrix storage and DotProduct2D", "[structured]") {
+  using cpp_matrix::Triangle;
+  using cpp_matrix::TriangularMatrix;
+
+  auto dense = Filled({7, 7}, 4);
+  auto lower = TriangularMatrix<int, Triangle::Lower>(dense);
+  auto upper = TriangularMatrix<int, Triangle::Upper>(dense);
+
+  REQUIRE(lower.data().size() == 28);
+  REQUIRE(upper.data().size() == 28);
+
+  auto lower_dense = cpp_matrix::ToMatrix2D(lower);
+  auto upper_dense = cpp_matrix::ToMatrix2D(upper);
+
+  for (int row = 0; row < 7; row++) {
+    for (int col = 0; col < 7; col++) {
+      int value = dense.get(row, col);
+      REQUIRE(lower_dense.get(row, col) == (row >= col ? value : 0));
+      REQUIRE(upper_dense.get(row, col) == (row <= col ? value : 0));
+      REQUIRE(std::as_const(lower).get(row, col) == lower_dense.get(row, col));
+    }
+  }
+
+  REQUIRE_THROWS_AS(lower.get(0, 1), std::out_of_range);
+  REQUIRE_THROWS_AS(upper.get(1, 0), std::out_of_range);
+
+  auto rhs = Filled({7, 3}, 5);
+  REQUIRE(cpp_matrix::DotProduct2D(lower, rhs) ==
+          cpp_matrix::DotProduct2D(lower_dense, rhs));
+  REQUIRE(cpp_matrix::DotProduct2D(upper, rhs) ==
+          cpp_matrix::DotProduct2D(upper_dense, rhs));
+}
+
+TEST_CASE("TriangularMatrix Transpose flips the triangle", "[structured]") {
+  using cpp_matrix::Triangle;
+  using cpp_matrix::TriangularMatrix;
+
+  auto lower = TriangularMatrix<int, Triangle::Lower>(Filled({5, 5}, 6));
+  auto packed = lower.data();
+
+  auto upper = cpp_matrix::Transpose(lower);
+  static_assert(
+      std::is_same_v<decltype(upper), TriangularMatrix<int, Triangle::Upper>>);
+
+  // Same packed buffer, no reordering
+  REQUIRE(upper.data() == packed);
+  REQUIRE(cpp_matrix::ToMatrix2D(upper) ==
+          cpp_matrix::Transpose(cpp_matrix::ToMatrix2D(lower)));
+  REQUIRE(cpp_matrix::Transpose(upper) == lower);
+
+  REQUIRE_THROWS_AS(
+      (TriangularMatrix<int, Triangle::Upper>(3, std::vector<int>(5))),
+      std::invalid_argument);
+}
+
+TEST_CASE("BandedMatrix storage, Transpose and DotProduct2D",
+          "[structured]") {
+  using cpp_matrix::BandedMatrix;
+
+  auto dense = Filled({8, 6}, 7);
+  auto banded = BandedMatrix<int>(dense, 2, 1);
+
+  REQUIRE(banded.data().size() == 8 * 4);
+  REQUIRE(banded.lower() == 2);
+  REQUIRE(banded.upper() == 1);
+
+  auto band_dense = cpp_matrix::ToMatrix2D(banded);
+  for (int row = 0; row < 8; row++) {
+    for (int col = 0; col < 6; col++) {
+      bool inside = col >= row - 2 and col <= row + 1;
+      REQUIRE(band_dense.get(row, col) == (inside ? dense.get(row, col) : 0));
+    }
+  }
+
+  REQUIRE_THROWS_AS(banded.get(0, 2), std::out_of_range);
+  REQUIRE_THROWS_AS(BandedMatrix<int>({3, 3}, -1, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(BandedMatrix<int>({3, 3}, -5, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(BandedMatrix<int>({3, 3}, 0, -5), std::invalid_argument);
+  REQUIRE_THROWS_AS(BandedMatrix<int>(dense, 1, -2), std::invalid_argument);
+
+  auto transposed = cpp_matrix::Transpose(banded);
+  REQUIRE(transposed.shape() == cpp_matrix::Shape2D{6, 8});
+  REQUIRE(transposed.lower() == 1);
+  REQUIRE(transposed.upper() == 2);
+  REQUIRE(cpp_matrix::ToMatrix2D(transposed) ==
+          cpp_matrix::Transpose(band_dense));
+
+  // Mat-vec and a wider rhs
+  auto vector = Filled({6, 1}, 8);
+  REQUIRE(cpp_matrix::DotProduct2D(banded, vector) ==
+          cpp_matrix::DotProduct2D(band_dense, vector));
+
+  auto rhs = Filled<cpp_matrix::ColMajor>({6, 5}, 9);
+  REQUIRE(cpp_matrix::DotProduct2D(banded, rhs) ==
+          cpp_matrix::DotProduct2D(
+              cpp_matrix::ConvertLayout<cpp_matrix::ColMajor>(band_dense),
+              rhs));
+}
+
+TEST_CASE("Structured views over dense storage", "[structured]") {
+  using cpp_matrix::BandedView;
+  using cpp_matrix::ColMajor;
+  using cpp_matrix::Matrix2DView;
+  using cpp_matrix::SymmetricView;
+  using cpp_matrix::Triangle;
+  using cpp_matrix::TriangularView;
+
+  SECTION("symmetric reads the lower triangle only") {
+    auto dense = Filled({6, 6}, 10);
+    auto view = SymmetricView(std::as_const(dense));
+    static_assert(std::is_same_v<decltype(view), SymmetricView<const int>>);
+
+    auto expected = cpp_matrix::SymmetricMatrix<int>(dense);
+    REQUIRE(cpp_matrix::ToMatrix2D(view) == cpp_matrix::ToMatrix2D(expected));
+    REQUIRE(view.get(1, 4) == dense.get(4, 1));
+
+    auto rhs = Filled({6, 3}, 11);
+    REQUIRE(cpp_matrix::DotProduct2D(view, rhs) ==
+            cpp_matrix::DotProduct2D(expected, rhs));
+    REQUIRE(cpp_matrix::ToMatrix2D(cpp_matrix::Transpose(view)) ==
+            cpp_matrix::ToMatrix2D(view));
+
+    // Writes go to the dense storage
+    auto mutable_view = SymmetricView(dense);
+    mutable_view.get(1, 4) = 42;
+    REQUIRE(dense.get(4, 1) == 42);
+
+    REQUIRE_THROWS_AS(SymmetricView(Filled({2, 3}, 0)),
+                      cpp_matrix::ShapeMismatchException);
+  }
+
+  SECTION("triangular over either layout") {
+    auto dense = Filled<ColMajor>({7, 7}, 12);
+    auto lower = TriangularView(std::as_const(dense));
+    auto upper = TriangularView<const int, Triangle::Upper>(dense);
+
+    auto packed_lower = cpp_matrix::TriangularMatrix<int>(dense);
+    auto packed_upper =
+        cpp_matrix::TriangularMatrix<int, Triangle::Upper>(dense);
+    REQUIRE(cpp_matrix::ToMatrix2D(lower) ==
+            cpp_matrix::ToMatrix2D(packed_lower));
+    REQUIRE(cpp_matrix::ToMatrix2D(upper) ==
+            cpp_matrix::ToMatrix2D(packed_upper));
+    REQUIRE(lower.get(0, 1) == 0);
+
+    auto rhs = Filled<ColMajor>({7, 2}, 13);
+    REQUIRE(cpp_matrix::DotProduct2D(lower, rhs) ==
+            cpp_matrix::DotProduct2D(packed_lower, rhs));
+    REQUIRE(cpp_matrix::DotProduct2D(upper, rhs) ==
+            cpp_matrix::DotProduct2D(packed_upper, rhs));
+
+    // Transposing swaps strides and flips the triangle
+    auto flipped = cpp_matrix::Transpose(lower);
+    static_assert(std::is_same_v<decltype(flipped),
+                                 TriangularView<const int, Triangle::Upper>>);
+    REQUIRE(flipped.dense().data() == dense.data().data());
+    REQUIRE(cpp_matrix::ToMatrix2D(flipped) ==
+            cpp_matrix::Transpose(cpp_matrix::ToMatrix2D(lower)));
+  }
+
+  SECTION("banded over a strided view") {
+    auto dense = Filled({8, 6}, 14);
+    auto view = BandedView(std::as_const(dense), 2, 1);
+    auto packed = cpp_matrix::BandedMatrix<int>(dense, 2, 1);
+
+    REQUIRE(cpp_matrix::ToMatrix2D(view) == cpp_matrix::ToMatrix2D(packed));
+    REQUIRE(view.get(0, 5) == 0);
+
+    auto vector = Filled({6, 1}, 15);
+    REQUIRE(cpp_matrix::DotProduct2D(view, vector) ==
+            cpp_matrix::DotProduct2D(packed, vector));
+    REQUIRE(cpp_matrix::ToMatrix2D(cpp_matrix::Transpose(view)) ==
+            cpp_matrix::ToMatrix2D(cpp_matrix::Transpose(packed)));
+
+    // Every other row of a taller buffer
+    auto tall = Filled({16, 6}, 14);
+    auto rows = Matrix2DView<const int>(tall.data().data(), {8, 6}, 12, 1);
+    auto strided = BandedView<const int>(rows, 2, 1);
+    REQUIRE(strided.get(3, 4) == tall.get(6, 4));
+
+    REQUIRE_THROWS_AS(BandedView(dense, -1, 0), std::invalid_argument);
+  }
+
+  SECTION("packed band as a matrix") {
+    auto packed = cpp_matrix::BandedMatrix<int>(Filled({5, 5}, 16), 1, 1);
+    auto band = packed.band();
+
+    REQUIRE(band.shape() == cpp_matrix::Shape2D{5, 3});
+    REQUIRE(band.get(2, 0) == packed.get(2, 1));
+    REQUIRE(band.get(2, 1) == packed.get(2, 2));
+    REQUIRE(band.get(2, 2) == packed.get(2, 3));
+
+    band.get(2, 2) = 42;
+    REQUIRE(packed.get(2, 3) == 42);
+    REQUIRE(std::as_const(packed).band().get(2, 2) == 42);
+  }
+}
@@ -2,11 +2,27 @@
 add_executable(
   test
   # Tests
-  test/test_matrix2d.cpp test/test_matrix2darray.cpp test/test_vec.cpp)
+  test/test_matrix2d.cpp test/test_matrix2darray.cpp test/test_vec.cpp
+  test/test_matrix2dview.cpp test/test_matrixchain.cpp test/test_quantized.cpp
+  test/test_strassen.cpp test/test_structured.cpp test/test_async.cpp)
 
 target_include_directories(test PUBLIC ${Catch2_INCLUDE_DIRS})
 target_include_directories(test PUBLIC src)
-target_link_libraries(test Catch2::Catch2WithMain)
+target_link_libraries(test Catch2::Catch2WithMain Threads::Threads)
+if(TBB_FOUND)
+  target_link_libraries(test TBB::tbb)
+endif()
+
+# Same library with CPP_MATRIX_PROFILING, the main tests cover the default
+# build where profiling compiles to nothing
+add_executable(test-profiling test/test_profiling.cpp)
+target_include_directories(test-profiling PUBLIC ${Catch2_INCLUDE_DIRS})
+target_include_directories(test-profiling PUBLIC src)
+target_link_libraries(test-profiling Catch2::Catch2WithMain Threads::Threads)
+target_compile_definitions(test-profiling PUBLIC CPP_MATRIX_PROFILING)
+if(TBB_FOUND)
+  target_link_libraries(test-profiling TBB::tbb)
+endif()
 
 add_executable(main-test test/main.cpp) # Non-Catch2 testing playground
 target_include_directories(main-test PUBLIC src)
\ No newline at end of file